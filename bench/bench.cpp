@@ -0,0 +1,487 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL_image.h>
+#include "app.h"
+
+/*
+        Benchmark suite: scanning, sorting, classification, layout and frame
+        rendering over a generated tree, reported as JSON (p50/p99 in ms and
+        heap allocations per run). Rendering goes through SDL's dummy video
+        driver and the software renderer, so no display or GPU is needed.
+
+        make bench BENCH_ARGS="--files 100000 --out bench.json"
+
+        The tree is generated from a seed, so the same options always give the
+        same names, sizes and shape. It is kept between runs and only rebuilt
+        when the options change.
+
+        A few behaviour checks run after the timings; the exit status is
+        non-zero when one of them fails.
+*/
+
+//every heap allocation made by the process, read before and after each timed run
+std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void *memory = malloc(size ? size : 1);
+    if(memory == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete[](void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+void operator delete[](void *memory, size_t) noexcept { free(memory); }
+
+typedef struct TreeSpec {
+    std::string root;
+    int files;
+    int fanout;
+    int depth;
+    int name_length;
+    unsigned seed;
+} TreeSpec;
+
+typedef struct BenchResult {
+    std::string name;
+    std::vector<double> times;  //ms
+    std::vector<uint64_t> allocations;
+} BenchResult;
+
+bool generateTree(TreeSpec *spec);
+bool checkNavigation(TreeSpec *spec);
+bool checkScanStats(TreeSpec *spec);
+bool checkUsageRefresh(TreeSpec *spec, ThreadPool *pool);
+bool checkNameArena(ThreadPool *pool);
+BenchResult runBench(const std::string &name, int runs, std::function<void()> setup, std::function<void()> run);
+double percentile(std::vector<double> values, double fraction);
+std::string formatResults(TreeSpec *spec, int entries, std::vector<BenchResult> *results);
+
+int main(int argc, char **argv)
+{
+    //tmpfs keeps the scan numbers about the code rather than the disk
+    TreeSpec spec = {access("/dev/shm", W_OK) == 0 ? "/dev/shm/fileexplorer-bench" : "/tmp/fileexplorer-bench", 10000, 8, 3, 12, 1};
+    int runs = 20;
+    std::string out;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        if(strcmp(argv[i], "--tree") == 0) spec.root = argv[i + 1];
+        else if(strcmp(argv[i], "--files") == 0) spec.files = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--fanout") == 0) spec.fanout = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--depth") == 0) spec.depth = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--name-length") == 0) spec.name_length = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--seed") == 0) spec.seed = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--runs") == 0) runs = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--out") == 0) out = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "Error: unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if(!generateTree(&spec))
+    {
+        return 1;
+    }
+
+    //headless: dummy video driver, software renderer on an offscreen surface
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDL_Init(SDL_INIT_VIDEO);
+    IMG_Init(IMG_INIT_PNG);
+    TTF_Init();
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer *renderer = SDL_CreateSoftwareRenderer(target);
+
+    AppData data;
+    data.font = TTF_OpenFont("resrc/OpenSans-Regular.ttf", 18);
+    if(renderer == NULL || data.font == NULL)
+    {
+        fprintf(stderr, "Error: headless renderer could not be set up: %s\n", SDL_GetError());
+        return 1;
+    }
+    initializeGlyphAtlas(renderer, data.font, &data.text);
+    initializeIcons(renderer, &data);
+    data.recursive_viewing_mode = true;
+    data.recursive_depth = WALK_UNLIMITED;
+    data.sniff_types = false;
+    data.sniffing.generation = 0;
+    data.thumbnails = false;
+    data.sort_order = {SORT_NAME, false};
+    data.filter_focused = false;
+    data.directory = spec.root;
+    //no live updates: recursive insertEntries asks to watch each directory, which does nothing without an inotify fd
+    data.watch.inotify_fd = -1;
+    data.watch.stop_fd = -1;
+    data.watch.limit_reported = false;
+    data.pool = createThreadPool(0);
+    data.background = createThreadPool(BACKGROUND_THREADS);
+    data.sizes.generation = 0;
+    data.expand_generation = 0;
+    data.hud_visible = false;
+    data.delete_armed = false;
+    data.frame_ms = 0;
+    data.entries.names_generation = 0;
+    initializeLayout(&data);
+    cleanEntries(&data);
+
+    //recursive listing shared by the benchmarks below
+    std::vector<EntryMeta> listing(1);
+    listing.at(0) = {spec.root + "/..", 0, 0, 0, true, false};
+    std::vector<EntryMeta> walked = walkDirectory(spec.root, WALK_UNLIMITED, data.pool, NULL, NULL);
+    listing.insert(listing.end(), walked.begin(), walked.end());
+
+    std::vector<BenchResult> results;
+    int sink = 0;
+
+    //one directory with metadata, what the original getFileData() did
+    results.push_back(runBench("scan_directory", runs, NULL, [&spec, &sink]() {
+        std::vector<EntryMeta> entries;
+        scanDirectory(spec.root, SCAN_TYPE | SCAN_METADATA, &entries, NULL);
+        sink += entries.size();
+    }));
+    //the whole tree, what "All Files" lists
+    results.push_back(runBench("walk_tree", runs, NULL, [&spec, &data, &sink]() {
+        sink += walkDirectory(spec.root, WALK_UNLIMITED, data.pool, NULL, NULL).size();
+    }));
+    results.push_back(runBench("classify", runs, NULL, [&listing, &sink]() {
+        for(int i = 0; i < listing.size(); i++)
+        {
+            sink += classifyEntry(&listing.at(i));
+        }
+    }));
+    //header layout plus every row going into the table, the UI-thread share of loading a listing
+    std::vector<EntryMeta> entries;
+    results.push_back(runBench("layout", runs, [&data, &spec, &entries, &listing]() {
+        cleanEntries(&data);
+        entries = listing;
+    }, [&data, &entries]() {
+        initializeLayout(&data);
+        insertEntries(&entries, 0, &data);
+    }));
+    results.push_back(runBench("sort_name", runs, [&data]() {
+        sortEntryTable(&data.entries, {SORT_SIZE, false}, data.pool);
+    }, [&data]() {
+        sortEntryTable(&data.entries, {SORT_NAME, false}, data.pool);
+    }));
+    results.push_back(runBench("sort_size", runs, [&data]() {
+        sortEntryTable(&data.entries, {SORT_NAME, false}, data.pool);
+    }, [&data]() {
+        sortEntryTable(&data.entries, {SORT_SIZE, true}, data.pool);
+    }));
+    //frames at scroll positions spread over the listing; the first frame warms the glyph atlas
+    int frame = 0;
+    render(renderer, &data);
+    results.push_back(runBench("render_frame", runs*10, [&data, &frame]() {
+        int rows = entryCount(&data.entries);
+        data.scroll_offset = (int)((long)(frame++)*7919 % rows)*data.row_height;
+    }, [renderer, &data]() {
+        render(renderer, &data);
+    }));
+
+    //checks [reported on stderr]
+    int failures = 0;
+    failures += !checkNavigation(&spec);
+    failures += !checkScanStats(&spec);
+    failures += !checkUsageRefresh(&spec, data.background);
+    failures += !checkNameArena(data.pool);
+
+    std::string json = formatResults(&spec, listing.size(), &results);
+    if(out.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(out);
+        file << json;
+    }
+
+    cleanIcons(&data);
+    cleanGlyphAtlas(&data.text);
+    TTF_CloseFont(data.font);
+    destroyThreadPool(data.background);
+    destroyThreadPool(data.pool);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    IMG_Quit();
+    TTF_Quit();
+    SDL_Quit();
+    return (sink == -1 || failures > 0) ? 1 : 0;
+}
+
+bool generateTree(TreeSpec *spec)
+{
+    //a tree built from the same options is reused
+    std::ostringstream description;
+    description << spec->files << " " << spec->fanout << " " << spec->depth << " " << spec->name_length << " " << spec->seed << "\n";
+    std::string marker = spec->root + "/.bench-tree";
+    std::ifstream existing(marker);
+    std::stringstream previous;
+    previous << existing.rdbuf();
+    if(previous.str() == description.str())
+    {
+        return true;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(spec->root, error);
+
+    //directories: fanout children per level, depth levels below the root
+    std::vector<std::string> directories(1, spec->root);
+    for(int level = 0, first = 0; level < spec->depth; level++)
+    {
+        int last = directories.size();
+        for(int d = first; d < last; d++)
+        {
+            for(int c = 0; c < spec->fanout; c++)
+            {
+                directories.push_back(directories.at(d) + "/dir" + std::to_string(c));
+            }
+        }
+        first = last;
+    }
+    for(int d = 0; d < directories.size(); d++)
+    {
+        if(!std::filesystem::create_directories(directories.at(d), error) && error)
+        {
+            fprintf(stderr, "Error: directory '%s' could not be created: %s\n", directories.at(d).c_str(), error.message().c_str());
+            return false;
+        }
+    }
+
+    //files are dealt round-robin; names, extensions and sizes come from the seeded generator
+    const char *extensions[] = {".txt", ".jpg", ".png", ".mp4", ".cpp", ".h", ".py", ".md", ""};
+    const char *alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
+    std::mt19937 random(spec->seed);
+    for(int f = 0; f < spec->files; f++)
+    {
+        std::string name;
+        for(int c = 0; c < spec->name_length; c++)
+        {
+            name += alphabet[random() % 64];
+        }
+        name += std::to_string(f) + extensions[random() % 9];
+        std::string path = directories.at(f % directories.size()) + "/" + name;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, (random() % 8 == 0) ? 0755 : 0644);
+        if(fd < 0)
+        {
+            fprintf(stderr, "Error: file '%s' could not be created: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        //sparse, so sizes vary without using memory
+        if(ftruncate(fd, random() % (1 << (random() % 24))) != 0)
+        {
+            fprintf(stderr, "Error: file '%s' could not be sized: %s\n", path.c_str(), strerror(errno));
+        }
+        close(fd);
+    }
+
+    std::ofstream file(marker);
+    file << description.str();
+    return true;
+}
+
+BenchResult runBench(const std::string &name, int runs, std::function<void()> setup, std::function<void()> run)
+{
+    BenchResult result;
+    result.name = name;
+    for(int r = 0; r < runs; r++)
+    {
+        if(setup)
+        {
+            setup();
+        }
+        uint64_t allocated = allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        result.allocations.push_back(allocations - allocated);
+        result.times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return result;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    //nearest rank
+    if(values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    int rank = (int)(fraction*values.size() + 0.999999) - 1;
+    return values.at(std::max(0, std::min<int>(rank, values.size() - 1)));
+}
+
+std::string formatResults(TreeSpec *spec, int entries, std::vector<BenchResult> *results)
+{
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"tree\": {\"root\": \"" << spec->root << "\", \"files\": " << spec->files << ", \"fanout\": " << spec->fanout
+         << ", \"depth\": " << spec->depth << ", \"name_length\": " << spec->name_length << ", \"seed\": " << spec->seed
+         << ", \"entries\": " << entries << "},\n";
+    json << "  \"benchmarks\": [\n";
+    for(int i = 0; i < results->size(); i++)
+    {
+        BenchResult *result = &results->at(i);
+        std::vector<double> allocated(result->allocations.begin(), result->allocations.end());
+        json << "    {\"name\": \"" << result->name << "\", \"runs\": " << result->times.size()
+             << ", \"p50_ms\": " << percentile(result->times, 0.5) << ", \"p99_ms\": " << percentile(result->times, 0.99)
+             << ", \"allocations_p50\": " << (uint64_t)percentile(allocated, 0.5) << "}"
+             << (i + 1 < results->size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+bool checkNavigation(TreeSpec *spec)
+{
+    //the ".." row followed by Backspace goes to the grandparent: both steps go through normalizeDirectory()
+    std::string child = spec->root + "/dir0/dir0";
+    std::string parent = normalizeDirectory(child + "/..");
+    std::string grandparent = normalizeDirectory(parent + "/..");
+    if(parent != spec->root + "/dir0" || grandparent != spec->root || normalizeDirectory("/..") != "/")
+    {
+        fprintf(stderr, "Error: check failed: '..' from '%s' gave '%s', then '%s'\n", child.c_str(), parent.c_str(), grandparent.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool checkScanStats(TreeSpec *spec)
+{
+    //a type-only scan takes no stat call per entry where readdir reports d_type [some filesystems report DT_UNKNOWN]
+    bool typed = true;
+    DIR *dir = opendir(spec->root.c_str());
+    struct dirent *entry;
+    while(dir != NULL && (entry = readdir(dir)) != NULL)
+    {
+        typed = typed && entry->d_type != DT_UNKNOWN;
+    }
+    if(dir != NULL)
+    {
+        closedir(dir);
+    }
+    ScanStats stats = {0, 0, 0};
+    std::vector<EntryMeta> entries;
+    scanDirectory(spec->root, SCAN_TYPE, &entries, &stats);
+    for(int i = 0; i < entries.size(); i++)
+    {
+        if(entries.at(i).is_directory)
+        {
+            std::vector<EntryMeta> children;
+            scanDirectory(spec->root + "/" + entries.at(i).path, SCAN_TYPE, &children, &stats);
+        }
+    }
+    bool passed = true;
+    if(typed && stats.stat_calls > 0)
+    {
+        fprintf(stderr, "Error: check failed: %llu stat calls for %llu entries with d_type available\n",
+                (unsigned long long)stats.stat_calls, (unsigned long long)stats.entries);
+        passed = false;
+    }
+
+    //without d_type the fallback stat must still see a symlink as one, or the walker would follow a loop
+    std::string links = spec->root + ".links";
+    std::string loop = links + "/loop";
+    std::error_code error;
+    std::filesystem::create_directories(links, error);
+    unlink(loop.c_str());
+    EntryMeta meta = {"loop", 0, 0, 0, false, false};
+    if(symlink(".", loop.c_str()) != 0 || !statEntry(AT_FDCWD, loop.c_str(), &meta, NULL) || !meta.is_link || !meta.is_directory)
+    {
+        fprintf(stderr, "Error: check failed: symlink '%s' was not recognised by the stat fallback\n", loop.c_str());
+        passed = false;
+    }
+    std::filesystem::remove_all(links, error);
+    return passed;
+}
+
+bool checkUsageRefresh(TreeSpec *spec, ThreadPool *pool)
+{
+    //a file appended to in place leaves its directory's stamps alone, so the watcher forgets the record
+    std::string dirname = spec->root + ".usage";
+    std::string file = dirname + "/grown";
+    std::error_code error;
+    std::filesystem::create_directories(dirname, error);
+    std::ofstream(file, std::ios::trunc) << std::string(1000, 'x');
+
+    UsageCache cache;
+    initializeUsageCache(&cache);
+    DirectoryUsage before = {0, 0, false};
+    DirectoryUsage after = {0, 0, false};
+    std::shared_ptr<UsageJob> job = startUsage({dirname}, pool, &cache, [](bool) {});
+    waitForTasks(pool, &job->group);
+    getUsage(job.get(), dirname, &before);
+
+    std::ofstream(file, std::ios::app) << std::string(1000, 'y');
+    forgetUsage(&cache, dirname);
+    job = startUsage({dirname}, pool, &cache, [](bool) {});
+    waitForTasks(pool, &job->group);
+    getUsage(job.get(), dirname, &after);
+    std::filesystem::remove_all(dirname, error);
+
+    if(before.bytes != 1000 || after.bytes != 2000)
+    {
+        fprintf(stderr, "Error: check failed: usage of '%s' went from %llu to %llu bytes after an append, expected 1000 to 2000\n",
+                dirname.c_str(), (unsigned long long)before.bytes, (unsigned long long)after.bytes);
+        return false;
+    }
+    return true;
+}
+
+bool checkNameArena(ThreadPool *pool)
+{
+    //removing most rows compacts the arena; the filter must fold the moved names again, not just the new ones
+    EntryTable table;
+    ListFilter filter;
+    table.names_generation = 0;
+    clearEntryTable(&table, "/arena");
+    resetFilter(&filter);
+    std::vector<EntryMeta> entries(20000, EntryMeta{"", 0, 0, 0, false, false});
+    std::vector<uint8_t> icon_types(entries.size(), 0);
+    for(int i = 0; i < entries.size(); i++)
+    {
+        entries.at(i).path = "/arena/file" + std::to_string(i);
+    }
+    insertEntryRows(&table, 0, &entries, &icon_types);
+    setFilterQuery(&filter, &table, "file19999", false, pool);
+    removeEntryRows(&table, 0, 15000);
+    for(int i = 0; i < entries.size(); i++)
+    {
+        entries.at(i).path = "/arena/more" + std::to_string(i);
+    }
+    insertEntryRows(&table, entryCount(&table), &entries, &icon_types);
+    setFilterQuery(&filter, &table, "file1999", false, pool);
+
+    size_t live = 0;
+    for(int i = 0; i < entryCount(&table); i++)
+    {
+        live += table.name_length.at(i);
+    }
+    bool passed = filter.matches.size() == 10 && entryName(&table, filter.matches.at(0)) == "file19990" &&
+                  table.names.size() <= 2*live + NAMES_COMPACT_MIN;
+    if(!passed)
+    {
+        fprintf(stderr, "Error: check failed: %d matches after compaction, arena %zu bytes for %zu live\n",
+                (int)filter.matches.size(), table.names.size(), live);
+    }
+    return passed;
+}
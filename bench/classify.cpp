@@ -0,0 +1,85 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "filetype.h"
+
+/*
+        Classification throughput on 1M synthetic names: the extension table
+        against the substring chain it replaced.
+        make classify-bench && ./bin/classify_bench
+*/
+
+#define NAME_COUNT 1000000
+#define ROUNDS 5
+
+int findChain(const std::string &file);
+
+int main()
+{
+    //mix of known, unknown, missing and misleading extensions
+    const char *suffixes[] = {".jpg", ".png", ".mp4", ".mkv", ".cpp", ".h", ".py", ".txt",
+                              ".c.txt", ".html", ".tar.gz", "", ".JPEG", ".webm", ".java", ".md"};
+    int suffix_count = sizeof(suffixes)/sizeof(suffixes[0]);
+    std::vector<std::string> names(NAME_COUNT);
+    for(int i = 0; i < NAME_COUNT; i++)
+    {
+        names.at(i) = "file_" + std::to_string((long)i*7919 % 100000) + suffixes[i % suffix_count];
+    }
+
+    double best_table = 0;
+    double best_chain = 0;
+    long checksum = 0;
+    for(int round = 0; round < ROUNDS; round++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int i = 0; i < NAME_COUNT; i++)
+        {
+            checksum += classifyName(names.at(i).data(), names.at(i).length());
+        }
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+        for(int i = 0; i < NAME_COUNT; i++)
+        {
+            checksum += findChain(names.at(i));
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double table = std::chrono::duration<double>(middle - start).count();
+        double chain = std::chrono::duration<double>(end - middle).count();
+        if(round == 0 || table < best_table) best_table = table;
+        if(round == 0 || chain < best_chain) best_chain = chain;
+    }
+
+    std::cout << "table: " << best_table*1000 << " ms, " << NAME_COUNT/best_table/1e6 << " M names/s" << std::endl;
+    std::cout << "find chain: " << best_chain*1000 << " ms, " << NAME_COUNT/best_chain/1e6 << " M names/s" << std::endl;
+    std::cout << "checksum: " << checksum << std::endl;
+    return 0;
+}
+
+int findChain(const std::string &file)
+{
+    //the previous classifier, kept here for comparison
+    if ((file.find(".jpg") != std::string::npos) ||
+        (file.find(".jpeg") != std::string::npos) ||
+        (file.find(".png") != std::string::npos) ||
+        (file.find(".tif") != std::string::npos) ||
+        (file.find(".tiff") != std::string::npos) ||
+        (file.find(".gif") != std::string::npos)) {
+        return 2;
+    } else if ((file.find(".mp4") != std::string::npos) ||
+                (file.find(".mov") != std::string::npos) ||
+                (file.find(".mkv") != std::string::npos) ||
+                (file.find(".avi") != std::string::npos) ||
+                (file.find(".webm") != std::string::npos)) {
+        return 3;
+    } else if ((file.find(".h") != std::string::npos) ||
+                (file.find(".c") != std::string::npos) ||
+                (file.find(".cpp") != std::string::npos) ||
+                (file.find(".py") != std::string::npos) ||
+                (file.find(".java") != std::string::npos) ||
+                (file.find(".js") != std::string::npos)) {
+        return 4;
+    } else {
+        return 5;
+    }
+}
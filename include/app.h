@@ -0,0 +1,218 @@
+#ifndef APP_H
+#define APP_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <vector>
+#include "text.h"
+#include "icons.h"
+#include "scan.h"
+#include "walk.h"
+#include "threadpool.h"
+#include "loader.h"
+#include "watch.h"
+#include "cache.h"
+#include "entries.h"
+#include "sort.h"
+#include "filetype.h"
+#include "filter.h"
+#include "treeindex.h"
+#include "trace.h"
+#include "selection.h"
+#include "tree.h"
+#include "thumbnail.h"
+#include "launcher.h"
+#include "transfer.h"
+#include "duplicates.h"
+#include <map>
+
+/*
+        Explorer window state and the functions that lay out, update and draw
+        it. main() owns the event loop; everything it calls lives here so the
+        same code can be driven by the benchmarks.
+*/
+
+#define WIDTH 800
+#define HEIGHT 600
+//rows drawn above and below the visible ones while scrolling
+#define ROW_OVERSCAN 4
+//top of the first row, right below the header
+#define LIST_TOP 25
+//left edge of the rows, and the expander in front of each directory
+#define ROW_LEFT 25
+#define EXPANDER_WIDTH 12
+//indentation per tree level
+#define INDENT 25
+//scrollbar track the thumb slides in
+#define SCROLL_TRACK_TOP 32
+#define SCROLL_TRACK_LENGTH 561
+#define SCROLL_THUMB_MIN 16
+//rows one wheel notch travels, and how fast a fling slows down [1/s]
+#define WHEEL_ROWS 3
+#define SCROLL_FRICTION 8.0
+
+//how a click or cursor move changes the selection: only that row, flip it, or extend from the anchor
+#define SELECT_ONLY 0
+#define SELECT_TOGGLE 1
+#define SELECT_EXTEND 2
+//moves the cursor and leaves the selection alone
+#define SELECT_NONE 3
+
+//workers for long background reads [disk usage, duplicate hashing, index refresh]
+#define BACKGROUND_THREADS 2
+
+typedef struct AppData {
+    TTF_Font *font;
+    GlyphAtlas text;
+    //listed files [row i shows entry i]
+    EntryTable entries;
+    //file icons, one atlas cell per icon type
+    IconAtlas icons;
+
+    //rows are laid out from their index: y = LIST_TOP + i*row_height - scroll_offset
+    int row_height;
+    int scroll_offset;
+    //kinetic scrolling: speed in px/s, sub-pixel carry and time of the last step
+    double scroll_velocity;
+    double scroll_fraction;
+    Uint32 scroll_time;
+
+    //header
+    SDL_Rect header_box;
+    SDL_Rect name_header_coordinates;
+    SDL_Rect size_header_coordinates;
+    SDL_Rect permissions_header_coordinates;
+    //button
+    SDL_Rect button_text_coordinates;
+    SDL_Rect recursive_button_outline;
+    SDL_Rect recursive_button;
+    bool recursive_viewing_mode;
+    int recursive_depth;
+    //read the first bytes of files without an extension to pick their icon [in the background]
+    bool sniff_types;
+    TypeSniffing sniffing;
+    //image rows show a scaled-down copy of the image instead of the icon
+    bool thumbnails;
+    ThumbnailCache thumbs;
+
+    //column the listing is sorted by, picked by clicking a header
+    SortOrder sort_order;
+
+    //filter box [when filtering, row i shows entry filter.matches[i]]
+    SDL_Rect filter_box;
+    std::string filter_text;
+    bool filter_focused;
+    ListFilter filter;
+
+    //scrollbar
+    SDL_Rect scrollbar_outline;
+    SDL_Rect scrollbar;
+    //where the thumb was grabbed, relative to its top
+    SDL_Point scrollbar_offset;
+    bool scrollbar_selected;
+
+    //selected entries and the keyboard cursor
+    Selection selection;
+    //collapsed subtrees, and the directories being expanded [one scan each]
+    TreeView tree;
+    std::map<std::string, DirectoryScan> expansions;
+    Uint32 expand_event;
+    int expand_generation;
+
+    //current directory
+    std::string directory;
+
+    //workers for directory scanning, filtering and sorting [the UI thread waits on these]
+    ThreadPool *pool;
+    //workers for reads that can run for minutes, so they never queue ahead of the UI's tasks
+    ThreadPool *background;
+    //recently scanned listings, for instant back-navigation
+    DirectoryCache cache;
+    //rebuilds the persistent tree index behind the cache [--index]
+    IndexRefresh index_refresh;
+    //background scan of the current directory
+    DirectoryScan scan;
+    Uint32 scan_event;
+    bool scan_finished;
+    //live updates of the listed directories
+    DirectoryWatch watch;
+    //handler applications started for opened files
+    Launcher launcher;
+    //background copy, move and delete, what Ctrl+C or Ctrl+X picked up, and a delete waiting for a second Delete
+    TransferQueue transfers;
+    std::vector<std::string> clipboard;
+    int clipboard_operation;
+    bool delete_armed;
+    //duplicate files of the listing [Ctrl+D]; once found, the filter shows only them, group by group
+    DuplicateSearch duplicates;
+    //recursive totals of the listed directories, shown in the size column
+    UsageCache usage_cache;
+    DirectorySizes sizes;
+    Uint32 sizes_event;
+
+    //timing overlay [F3]: last frames' render time and how fast the current scan delivers entries
+    bool hud_visible;
+    double frame_ms;
+    Uint64 scan_started;
+    int scan_entries;
+    double scan_rate;
+
+} AppData;
+
+void initialize(SDL_Renderer *renderer, AppData *data_ptr);
+void initializeLayout(AppData *data_ptr);
+void initializeIcons(SDL_Renderer *renderer, AppData *data_ptr);
+void render(SDL_Renderer *renderer, AppData *data_ptr);
+void insertEntries(std::vector<EntryMeta> *entries, int position, AppData *data_ptr);
+void removeEntries(int position, int count, AppData *data_ptr);
+void updateScrollbar(AppData *data_ptr);
+int maxScroll(AppData *data_ptr);
+void scrollTo(int offset, AppData *data_ptr);
+void scrollPage(int pages, AppData *data_ptr);
+void dragScrollbar(int y, AppData *data_ptr);
+void flingScroll(int notches, AppData *data_ptr);
+bool stepScroll(AppData *data_ptr);
+void applyChanges(SDL_Renderer *renderer, AppData *data_ptr);
+bool isWatchedDirectory(EntryMeta *meta, AppData *data_ptr);
+void startSizes(AppData *data_ptr);
+void applySizes(AppData *data_ptr);
+void sniffEntries(std::vector<EntryMeta> *entries, std::vector<uint8_t> *icon_types, AppData *data_ptr);
+bool applySniffedTypes(SDL_Event *event, AppData *data_ptr);
+void setSortOrder(int key, AppData *data_ptr);
+bool onRect(int x, int y, SDL_Rect *rect);
+int rowAt(int x, int y, AppData *data_ptr);
+int rowCount(AppData *data_ptr);
+int rowEntry(int row, AppData *data_ptr);
+std::string rowLabel(int i, AppData *data_ptr);
+int entryRow(int i, AppData *data_ptr);
+void selectRow(int row, int mode, AppData *data_ptr);
+void moveCursor(int rows, int mode, AppData *data_ptr);
+void selectAll(AppData *data_ptr);
+void revealRow(int row, AppData *data_ptr);
+void openEntry(SDL_Renderer *renderer, int i, AppData *data_ptr);
+void openParent(SDL_Renderer *renderer, AppData *data_ptr);
+std::string normalizeDirectory(const std::string &dir);
+std::vector<std::string> selectedPaths(AppData *data_ptr);
+void copySelection(int operation, AppData *data_ptr);
+void pasteClipboard(AppData *data_ptr);
+void deleteSelection(AppData *data_ptr);
+void toggleDuplicates(AppData *data_ptr);
+bool applyDuplicates(SDL_Event *event, AppData *data_ptr);
+int rowIndent(int i, AppData *data_ptr);
+int expanderAt(int x, int y, AppData *data_ptr);
+void toggleEntry(int i, AppData *data_ptr);
+void expandCursor(bool expand, AppData *data_ptr);
+void startExpansion(const std::string &path, int max_depth, AppData *data_ptr);
+bool applyExpansion(SDL_Renderer *renderer, SDL_Event *event, AppData *data_ptr);
+void cancelExpansions(AppData *data_ptr);
+void setFilterText(const std::string &text, bool fuzzy, AppData *data_ptr);
+void resortEntries(AppData *data_ptr);
+void cleanEntries(AppData *data_ptr);
+void cleanIcons(AppData *data_ptr);
+void countScanned(int entries, AppData *data_ptr);
+void renderHud(SDL_Renderer *renderer, AppData *data_ptr);
+void renderStatus(SDL_Renderer *renderer, AppData *data_ptr);
+int slashCount(std::string path);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "scan.h"
+
+/*
+        LRU cache of scanned directory listings, bounded by an estimate of the
+        memory they hold. A listing is only reused while the directory's
+        device, inode, mtime and ctime are unchanged, so revisiting a directory
+        costs a single statx instead of a rescan. File contents can change
+        without touching the directory, so cached sizes may lag until the entry
+        is rescanned or the watcher reports the change.
+
+        Listings missing from the cache are looked up in the mapped tree index
+        (treeindex.h), when one is attached, under the same stamp check.
+*/
+
+#define CACHE_DEFAULT_BUDGET (64*1024*1024)
+
+//identity and version of a directory at the time it was scanned
+typedef struct DirectoryStamp {
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+} DirectoryStamp;
+
+typedef struct CachedListing {
+    std::string path;
+    DirectoryStamp stamp;
+    std::vector<EntryMeta> entries;
+    size_t bytes;
+} CachedListing;
+
+typedef struct CacheStats {
+    uint64_t hits;
+    uint64_t index_hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t bytes;
+    size_t listings;
+} CacheStats;
+
+typedef struct DirectoryCache {
+    std::mutex lock;
+    size_t budget;
+    size_t used;
+    std::list<CachedListing> lru;  //most recently used first
+    std::unordered_map<std::string, std::list<CachedListing>::iterator> index;
+    uint64_t hits;
+    uint64_t index_hits;
+    uint64_t misses;
+    uint64_t evictions;
+
+    //persistent index consulted on a miss, swapped whole when it is rebuilt
+    std::shared_ptr<struct TreeIndex> tree;
+} DirectoryCache;
+
+void initializeDirectoryCache(DirectoryCache *cache, size_t budget);
+bool stampDirectory(const std::string &dirname, DirectoryStamp *stamp);
+bool lookupListing(DirectoryCache *cache, const std::string &dirname, const DirectoryStamp &stamp, std::vector<EntryMeta> *entries);
+void storeListing(DirectoryCache *cache, const std::string &dirname, const DirectoryStamp &stamp, const std::vector<EntryMeta> &entries);
+CacheStats getCacheStats(DirectoryCache *cache);
+void setCacheTree(DirectoryCache *cache, std::shared_ptr<struct TreeIndex> tree);
+std::shared_ptr<struct TreeIndex> getCacheTree(DirectoryCache *cache);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include <SDL.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "entries.h"
+#include "threadpool.h"
+
+/*
+        Duplicate file finder over the loaded listing [Ctrl+D]. Files are
+        bucketed by exact size from the size column without touching the
+        disk; only files sharing a size are kept. Those are checked for hard
+        links [one lstat each], and paths to the same inode are folded into
+        one file that is read once. The rest are hashed on their first and
+        last DUP_EDGE_BYTES, and only files that still collide are hashed in
+        full, read DUP_READ_BYTES at a time. Every stage is spread over the
+        pool it is given, which should not be one the UI thread waits on: a
+        task may read gigabytes. Bucketing takes a (size, row) pair per
+        listed regular file; after that only candidates are kept.
+
+        Groups are ranked by the space their extra copies waste; hard links
+        are shown in their group but waste nothing, and links alone do not
+        make a group. The window shows groups by marking each file with its
+        group rank in the entry table.
+*/
+
+#define DUP_EDGE_BYTES 4096
+#define DUP_READ_BYTES (1024*1024)
+//files hashed per pool task
+#define DUP_FILES_PER_TASK 64
+#define DUP_PROGRESS_MS 100
+
+#define DUP_STAGE_LINKS 0
+#define DUP_STAGE_EDGES 1
+#define DUP_STAGE_FULL 2
+
+typedef struct DuplicateFile {
+    std::string path;
+    uint64_t size;
+    uint64_t hash[2];
+    uint64_t device;
+    uint64_t inode;
+    std::vector<int> links;  //other candidates that are hard links to this one
+    bool readable;
+} DuplicateFile;
+
+//shared with the pool tasks, which may outlive the search
+typedef struct DuplicateJob {
+    std::vector<DuplicateFile> files;  //candidates, sorted by size
+    std::vector<std::vector<std::string> > groups;
+    TaskGroup group;
+    std::atomic<int> stage;
+    std::atomic<int> files_done;
+    std::atomic<int> files_total;
+    std::atomic<uint64_t> bytes_read;
+    uint64_t bytes_listed;  //what hashing every listed file in full would read
+    uint64_t wasted;        //bytes taken by all but one file of each group
+    std::atomic<bool> finished;
+    std::atomic<Uint32> last_notify;
+    Uint32 event_type;
+    int generation;
+} DuplicateJob;
+
+typedef struct DuplicateSearch {
+    std::shared_ptr<DuplicateJob> job;
+    Uint32 event_type;
+    int generation;
+} DuplicateSearch;
+
+void startDuplicateSearch(DuplicateSearch *search, EntryTable *table, ThreadPool *pool);
+void cancelDuplicateSearch(DuplicateSearch *search);
+bool isCurrentDuplicates(DuplicateSearch *search, SDL_Event *event);
+bool isDuplicateSearchRunning(DuplicateSearch *search);
+int markDuplicates(DuplicateSearch *search, EntryTable *table);
+std::string duplicateStatus(DuplicateSearch *search);
+
+#endif
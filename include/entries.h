@@ -0,0 +1,73 @@
+#ifndef ENTRIES_H
+#define ENTRIES_H
+
+#include <stdint.h>
+#include <string>
+#include <filesystem>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+#include "scan.h"
+
+/*
+        The listing as a struct-of-arrays table: row i of the view is entry i.
+        Names live back to back in one arena and point at an interned parent
+        directory instead of each entry holding its full path. Sizes and modes
+        are stored raw; display strings are formatted only for visible rows.
+*/
+
+//entry flags
+#define ENTRY_DIRECTORY 0x1
+#define ENTRY_LINK 0x2
+#define ENTRY_SIZED 0x4     //directory whose size column holds its recursive total
+#define ENTRY_PARTIAL 0x8   //that total is still growing
+#define ENTRY_EXPANDED 0x10 //directory whose children are in the table, or being loaded
+#define ENTRY_COLLAPSED 0x20 //expanded directory whose children are hidden
+
+//removed names are squeezed out of the arena once they fill half of it and at least this many bytes
+#define NAMES_COMPACT_MIN (64*1024)
+
+typedef struct EntryTable {
+    //path of the listed directory, depth 0
+    std::string root;
+    int root_slashes;
+
+    //per-entry columns
+    std::vector<uint32_t> name_offset;
+    std::vector<uint16_t> name_length;
+    std::vector<uint32_t> parent;
+    std::vector<uint16_t> depth;
+    std::vector<uint64_t> size;
+    std::vector<mode_t> mode;
+    std::vector<int64_t> mtime;
+    std::vector<uint8_t> icon_type;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> duplicate_group;  //0, or the rank of the duplicate group the file is in
+
+    //name arena [not null-terminated]; removed names stay until they fill half of it, so it
+    //holds at most twice the listed names' bytes, or NAMES_COMPACT_MIN more than them
+    std::vector<char> names;
+    size_t dead_names;          //bytes of removed names still in the arena
+    uint32_t names_generation;  //changes whenever names move [cleared or compacted]
+
+    //interned parent directories
+    std::vector<std::string> directories;
+    std::vector<uint16_t> directory_depth;
+    std::unordered_map<std::string, uint32_t> directory_index;
+} EntryTable;
+
+void clearEntryTable(EntryTable *table, const std::string &root);
+int entryCount(EntryTable *table);
+void insertEntryRows(EntryTable *table, int position, std::vector<EntryMeta> *entries, std::vector<uint8_t> *icon_types);
+void removeEntryRows(EntryTable *table, int position, int count);
+void updateEntryRow(EntryTable *table, int position, EntryMeta *meta, uint8_t icon_type);
+void permuteEntryRows(EntryTable *table, const std::vector<int> &order);
+std::string entryName(EntryTable *table, int i);
+std::string entryPath(EntryTable *table, int i);
+int findEntry(EntryTable *table, const std::string &path, bool *found);
+int findEntryUnordered(EntryTable *table, const std::string &path, bool *found);
+int subtreeSize(EntryTable *table, int i);
+std::string formatSize(uint64_t size);
+std::string getPermissions(std::filesystem::perms p);
+
+#endif
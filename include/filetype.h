@@ -0,0 +1,33 @@
+#ifndef FILETYPE_H
+#define FILETYPE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "scan.h"
+
+/*
+        File type classification for the row icons. The extension after the
+        last dot is looked up in a table built at compile time, so "notes.c.txt"
+        is a text file and "a.html" is not a header. Files without an extension
+        can optionally be sniffed from their first few bytes.
+*/
+
+//icon index of each type [cell order of the icon atlas]
+#define ICON_DIRECTORY 0
+#define ICON_EXECUTABLE 1
+#define ICON_IMAGE 2
+#define ICON_VIDEO 3
+#define ICON_CODE 4
+#define ICON_OTHER 5
+#define ICON_TYPES 6
+
+//bytes read from a file when sniffing its type
+#define SNIFF_BYTES 16
+
+int classifyName(const char *name, size_t length);
+int classifyEntry(EntryMeta *meta);
+int sniffFileType(const std::string &path);
+bool needsSniffing(EntryMeta *meta, int icon_type);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <string>
+#include <vector>
+#include "entries.h"
+#include "threadpool.h"
+
+/*
+        Filter-as-you-type over the loaded listing. Names are matched
+        case-insensitively against a folded copy of the name arena, either as a
+        substring or as a subsequence (fuzzy). A query that extends the previous
+        one only re-checks the previous matches. Any change to the table marks
+        the filter stale, and the next refresh matches every entry again.
+        With duplicates set, only files in a duplicate group are candidates,
+        and rows follow the group ranks instead of the listing order.
+*/
+
+//entries matched per pool task
+#define FILTER_CHUNK 32768
+
+typedef struct ListFilter {
+    std::string query;         //case-folded
+    bool fuzzy;
+    bool stale;
+    bool duplicates;
+    std::vector<int> matches;  //matching entries, in listing order [group order with duplicates]
+
+    //case-folded copy of the name arena, with padding so 16-byte loads never run off the end
+    std::vector<char> folded;
+    size_t folded_length;
+    uint32_t folded_generation;  //names_generation of the arena it was folded from
+} ListFilter;
+
+void resetFilter(ListFilter *filter);
+bool isFiltering(ListFilter *filter);
+void setFilterQuery(ListFilter *filter, EntryTable *table, const std::string &query, bool fuzzy, ThreadPool *pool);
+void refreshFilter(ListFilter *filter, EntryTable *table, ThreadPool *pool);
+bool matchName(const char *name, size_t length, const char *query, size_t query_length, bool fuzzy);
+
+#endif
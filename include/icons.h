@@ -0,0 +1,35 @@
+#ifndef ICONS_H
+#define ICONS_H
+
+#include <SDL.h>
+#include <vector>
+#include "filetype.h"
+
+/*
+        Row icons packed into one atlas texture. Each icon is loaded once at
+        startup, box-filtered down to ICON_CELL pixels and copied into its cell,
+        and rows queue textured quads that are drawn together, so all icons of
+        a frame take one SDL_RenderGeometry call.
+*/
+
+//side of one icon in the atlas [the source images are far larger than any row]
+#define ICON_CELL 64
+#define ICON_COLUMNS 3
+#define ICON_ROWS ((ICON_TYPES + ICON_COLUMNS - 1)/ICON_COLUMNS)
+
+typedef struct IconAtlas {
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    SDL_Rect source[ICON_TYPES];
+
+    //quads queued since the last flush
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+} IconAtlas;
+
+bool initializeIconAtlas(SDL_Renderer *renderer, IconAtlas *atlas);
+void cleanIconAtlas(IconAtlas *atlas);
+void queueIcon(IconAtlas *atlas, int type, const SDL_Rect *dest);
+void flushIcons(IconAtlas *atlas);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sys/types.h>
+#include "filetype.h"
+
+/*
+        Opens files in their handler application. Children are started with
+        posix_spawnp, which does not copy the explorer's address space, and are
+        reaped from the event loop: SIGCHLD is blocked in every thread and read
+        from a signalfd by a small thread that only wakes the loop. The handler
+        program of each icon type is looked up on PATH once. Opening many
+        files at once queues them, and at most LAUNCH_BATCH handlers run at a
+        time.
+*/
+
+#define LAUNCH_BATCH 8
+//handler program per icon type [NULL for types opened inside the explorer]
+#define LAUNCH_HANDLERS {NULL, "xdg-open", "xdg-open", "xdg-open", "xdg-open", "xdg-open"}
+
+typedef struct LaunchRequest {
+    std::string path;
+    int icon_type;
+} LaunchRequest;
+
+typedef struct Launcher {
+    int signal_fd;
+    int stop_fd;
+    std::thread reaper;
+    Uint32 event_type;
+    std::atomic<bool> notified;
+
+    //below is only touched by the event loop
+    std::string handlers[ICON_TYPES];  //resolved program path, empty until looked up
+    bool resolved[ICON_TYPES];
+    std::deque<LaunchRequest> queued;
+    std::unordered_map<pid_t, std::string> running;  //pid -> file it opens
+} Launcher;
+
+void blockChildSignal();
+bool startLauncher(Launcher *launcher, Uint32 event_type);
+void stopLauncher(Launcher *launcher);
+void launchFile(Launcher *launcher, const std::string &path, int icon_type);
+bool reapChildren(Launcher *launcher, SDL_Event *event);
+
+#endif
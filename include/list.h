@@ -0,0 +1,26 @@
+#ifndef LIST_H
+#define LIST_H
+
+#include <string>
+#include "threadpool.h"
+
+/*
+        Headless listing [--list DIR]. Runs the same walker, classification
+        and permission formatting as the window, without SDL, and writes each
+        run of entries to stdout as soon as the walker hands it out, so output
+        starts right away and memory stays within the walker's scan-ahead
+        limits however slowly stdout is read. Paths are relative to DIR and
+        sizes are in bytes.
+*/
+
+#define LIST_TSV 0
+#define LIST_JSON 1
+#define LIST_NDJSON 2
+
+//stdout buffer; each batch is formatted into one string and written at once
+#define LIST_BUFFER_SIZE (1 << 20)
+
+int parseListFormat(const char *name);
+int listDirectory(const std::string &dirname, int max_depth, int format, ThreadPool *pool);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "walk.h"
+#include "usage.h"
+
+/*
+        Background directory loading. A walk runs on the thread pool and its
+        entries pile up in a ScanResults buffer; whenever the buffer goes from
+        empty to non-empty a user event is pushed so the event loop wakes up
+        and drains it. Each scan has a generation number, and events from an
+        older generation are ignored. Directory sizes are computed the same
+        way, except that the totals stay in the usage job and are read from
+        there. Types sniffed from file contents [--sniff] come back the same
+        way too, as (path, type) pairs applied to whatever rows are still
+        listed.
+*/
+
+//files sniffed per pool task
+#define SNIFF_BATCH 64
+
+typedef struct ScanResults {
+    std::mutex lock;
+    std::vector<EntryMeta> entries;
+    bool finished;
+    bool notified;
+    Uint32 event_type;
+    int generation;
+} ScanResults;
+
+//directory totals are polled by the event loop; at most one wake-up event is pending
+typedef struct SizeUpdates {
+    std::atomic<bool> notified;
+    Uint32 event_type;
+    int generation;
+} SizeUpdates;
+
+typedef struct DirectorySizes {
+    std::shared_ptr<UsageJob> job;
+    std::shared_ptr<SizeUpdates> updates;
+    int generation;
+} DirectorySizes;
+
+typedef struct SniffResults {
+    TaskGroup group;
+    std::mutex lock;
+    std::vector<std::pair<std::string, uint8_t> > types;  //only files the contents told something about
+    bool notified;
+    Uint32 event_type;
+    int generation;
+} SniffResults;
+
+typedef struct TypeSniffing {
+    std::shared_ptr<SniffResults> results;
+    Uint32 event_type;
+    int generation;
+} TypeSniffing;
+
+typedef struct DirectoryScan {
+    std::shared_ptr<WalkJob> job;
+    std::shared_ptr<ScanResults> results;
+    int generation;
+} DirectoryScan;
+
+void startDirectoryScan(DirectoryScan *scan, const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, Uint32 event_type);
+void cancelDirectoryScan(DirectoryScan *scan);
+bool isCurrentScan(DirectoryScan *scan, SDL_Event *event);
+bool takeScanResults(DirectoryScan *scan, std::vector<EntryMeta> *entries);
+void startDirectorySizes(DirectorySizes *sizes, const std::vector<std::string> &directories, ThreadPool *pool, UsageCache *cache, Uint32 event_type);
+void cancelDirectorySizes(DirectorySizes *sizes);
+bool isCurrentSizes(DirectorySizes *sizes, SDL_Event *event);
+bool takeSizeUpdate(DirectorySizes *sizes);
+void queueSniffing(TypeSniffing *sniffing, std::vector<std::string> paths, ThreadPool *pool);
+void cancelSniffing(TypeSniffing *sniffing);
+bool isCurrentSniffing(TypeSniffing *sniffing, SDL_Event *event);
+void takeSniffedTypes(TypeSniffing *sniffing, std::vector<std::pair<std::string, uint8_t> > *types);
+
+#endif
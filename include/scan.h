@@ -0,0 +1,40 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+        Directory scanner: one readdir pass per directory, using d_type for the
+        file type and at most one statx (relative to the open directory fd) per
+        entry for everything else. A symlink takes a second one for its target;
+        the walker never descends a link.
+*/
+
+//what a scan has to fill in
+#define SCAN_TYPE 0x1       //directory or not [free when the filesystem reports d_type]
+#define SCAN_METADATA 0x2   //mode, size and mtime [one statx per entry]
+
+//everything the explorer needs to know about one entry, filled in once
+typedef struct EntryMeta {
+    std::string path;
+    mode_t mode;
+    uint64_t size;
+    int64_t mtime;
+    bool is_directory;
+    bool is_link;
+} EntryMeta;
+
+//syscall counters, summed over every scan they are passed to
+typedef struct ScanStats {
+    uint64_t directories;
+    uint64_t entries;
+    uint64_t stat_calls;
+} ScanStats;
+
+int scanDirectory(const std::string &dirname, int fields, std::vector<EntryMeta> *entries, ScanStats *stats);
+bool statEntry(int dirfd, const char *name, EntryMeta *entry, ScanStats *stats);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+        Selected entries as a bitset over entry indices, plus the cursor the
+        keyboard moves and the anchor shift-selection extends from. The bitset
+        follows the entry table through inserts, removals and sorts, so a
+        selection survives live updates and re-sorting.
+*/
+
+typedef struct Selection {
+    std::vector<uint64_t> bits;  //bit i set when entry i is selected
+    int count;                   //entries covered
+    int cursor;                  //entry the keyboard acts on, -1 for none
+    int anchor;                  //entry a shift-selection extends from
+} Selection;
+
+void resetSelection(Selection *selection);
+void insertSelectionRows(Selection *selection, int position, int count);
+void removeSelectionRows(Selection *selection, int position, int count);
+void permuteSelection(Selection *selection, const std::vector<int> &order);
+bool isSelected(Selection *selection, int i);
+void setSelected(Selection *selection, int i, bool selected);
+void selectRange(Selection *selection, int first, int last, bool selected);
+void clearSelection(Selection *selection);
+int selectedCount(Selection *selection);
+std::vector<int> selectedEntries(Selection *selection);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <string>
+#include <vector>
+#include "entries.h"
+#include "threadpool.h"
+
+/*
+        Sorting of the listing. Names compare case-insensitively in natural
+        order ("file2" before "file10"). Sorting keeps the tree intact: siblings
+        are ordered among themselves and every directory is still followed by
+        its own contents. Keys are folded once per sort into one buffer laid
+        out like the name arena, and large groups are sorted on the pool.
+*/
+
+//sort keys
+#define SORT_NAME 0
+#define SORT_SIZE 1
+#define SORT_PERMISSIONS 2
+#define SORT_TYPE 3
+#define SORT_MTIME 4
+
+//below this many entries a group is sorted on the calling thread
+#define PARALLEL_SORT_THRESHOLD 16384
+
+typedef struct SortOrder {
+    int key;
+    bool descending;
+} SortOrder;
+
+std::vector<int> sortEntryTable(EntryTable *table, SortOrder order, ThreadPool *pool);
+bool isPathOrder(SortOrder order);
+int naturalCompare(const char *first, size_t first_length, const char *second, size_t second_length);
+bool compareNatural(const std::string &first, const std::string &second);
+bool comparePreOrder(const std::string &first, const std::string &second);
+void foldCase(const char *text, size_t length, char *folded);
+
+#endif
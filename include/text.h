@@ -0,0 +1,52 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+        Text is drawn from a single atlas texture: each glyph of the font is
+        rasterized once the first time it is used, and strings are emitted as
+        textured quads that are submitted together with SDL_RenderGeometry.
+*/
+
+#define ATLAS_SIZE 1024
+
+//one rasterized glyph inside the atlas
+typedef struct Glyph {
+    SDL_Rect source;
+    int advance;
+} Glyph;
+
+typedef struct GlyphAtlas {
+    TTF_Font *font;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    int line_height;
+
+    //shelf packer position for the next glyph
+    int pen_x;
+    int pen_y;
+    int shelf_height;
+
+    //ascii is looked up directly, everything else by code point
+    Glyph ascii[128];
+    bool ascii_loaded[128];
+    std::unordered_map<Uint32, Glyph> extended;
+
+    //quads queued since the last flush
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+} GlyphAtlas;
+
+bool initializeGlyphAtlas(SDL_Renderer *renderer, TTF_Font *font, GlyphAtlas *atlas);
+void cleanGlyphAtlas(GlyphAtlas *atlas);
+int measureText(GlyphAtlas *atlas, const char *text);
+int queueText(GlyphAtlas *atlas, const char *text, int x, int y, SDL_Color color);
+void flushText(GlyphAtlas *atlas);
+Uint32 nextCodePoint(const char **text);
+
+#endif
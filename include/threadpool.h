@@ -0,0 +1,52 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+        Work-stealing thread pool. Every worker owns a deque: it pushes and pops
+        its own work at the back and idle workers steal from the front of the
+        others. Tasks belong to a TaskGroup so a caller can wait for just the
+        work it started; a worker that waits keeps running tasks meanwhile.
+*/
+
+typedef struct TaskGroup {
+    std::atomic<int> pending;
+    std::atomic<bool> cancelled;
+} TaskGroup;
+
+typedef struct Task {
+    std::function<void()> run;
+    TaskGroup *group;
+} Task;
+
+typedef struct WorkerQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+} WorkerQueue;
+
+typedef struct ThreadPool {
+    std::vector<std::thread> threads;
+    std::vector<WorkerQueue*> queues;
+    std::atomic<int> queued;
+    std::atomic<unsigned> next_queue;
+    bool stopping;
+    //sleeping workers and group waiters
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+} ThreadPool;
+
+ThreadPool* createThreadPool(int threads);
+void destroyThreadPool(ThreadPool *pool);
+void initializeTaskGroup(TaskGroup *group);
+void submitTask(ThreadPool *pool, TaskGroup *group, std::function<void()> run);
+void waitForTasks(ThreadPool *pool, TaskGroup *group);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include <SDL.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "threadpool.h"
+
+/*
+        Thumbnails for image rows [--thumbnails]. Rows in or near the view ask
+        for their thumbnail every frame; a missing one is decoded and scaled
+        down on a small pool of decoder threads, and the pixels are handed back
+        to the render thread, which uploads a few per frame. Requests that have
+        scrolled out of view by the time a decoder gets to them are dropped.
+        Textures live in an LRU cache with a byte budget. Files that failed
+        to decode are kept in it too, at a nominal cost, under their mtime and
+        size, so they age out and a changed file is tried again. With a disk
+        cache directory, scaled pixels are also kept on disk under path, mtime
+        and size, so revisits skip decoding.
+*/
+
+//longest side of a thumbnail
+#define THUMB_SIZE 64
+#define THUMB_DECODERS 2
+//textures created per frame, so a screen full of new thumbnails never stalls one frame
+#define THUMB_UPLOADS_PER_FRAME 8
+#define THUMB_DEFAULT_BUDGET (32*1024*1024)
+//budget charged for a file that could not be decoded, so failures age out with the rest
+#define THUMB_FAILURE_BYTES 256
+#define THUMB_MAGIC 0x48545846
+
+typedef struct Thumbnail {
+    SDL_Texture *texture;  //NULL when the file could not be decoded
+    int width;
+    int height;
+    int64_t mtime;
+    uint64_t size;
+    size_t bytes;
+    std::list<std::string>::iterator lru;
+} Thumbnail;
+
+typedef struct DecodedThumbnail {
+    std::string path;
+    int64_t mtime;
+    uint64_t size;
+    SDL_Surface *surface;
+} DecodedThumbnail;
+
+//shared with the decoder tasks, which may outlive the cache
+typedef struct ThumbnailQueue {
+    std::mutex lock;
+    //requested paths and the frame they were last wanted in
+    std::unordered_map<std::string, unsigned> pending;
+    std::vector<DecodedThumbnail> decoded;
+    std::atomic<unsigned> frame;
+    std::atomic<bool> notified;
+    Uint32 event_type;
+    std::string disk_dir;
+} ThumbnailQueue;
+
+typedef struct ThumbnailCache {
+    ThreadPool *decoders;
+    TaskGroup group;
+    std::shared_ptr<ThumbnailQueue> queue;
+    std::unordered_map<std::string, Thumbnail> thumbnails;
+    std::list<std::string> lru;  //most recently drawn first
+    size_t budget;
+    size_t bytes;
+} ThumbnailCache;
+
+std::string defaultThumbnailDir();
+void initializeThumbnails(ThumbnailCache *cache, size_t budget, const std::string &disk_dir, Uint32 event_type);
+void cleanThumbnails(ThumbnailCache *cache);
+void beginThumbnailFrame(ThumbnailCache *cache);
+SDL_Texture* findThumbnail(ThumbnailCache *cache, const std::string &path, int64_t mtime, uint64_t size, int *width, int *height);
+bool uploadThumbnails(SDL_Renderer *renderer, ThumbnailCache *cache);
+
+#endif
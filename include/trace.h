@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+/*
+        Scoped trace points. Each thread records into its own ring buffer, so
+        recording takes no lock; the newest TRACE_RING_SIZE events per thread
+        are kept and can be written out as Chrome/Perfetto trace JSON. While
+        tracing is off a trace point costs one relaxed load.
+
+        FILEEXPLORER_TRACE=file starts tracing at launch and writes the file on
+        exit; F12 starts tracing, or writes the file if it is already running.
+*/
+
+//events kept per thread [power of two]
+#define TRACE_RING_SIZE 65536
+#define TRACE_ENV "FILEEXPLORER_TRACE"
+#define TRACE_DEFAULT_FILE "fileexplorer-trace.json"
+
+//complete events span [start, start + duration); counters only use value
+#define TRACE_COMPLETE 'X'
+#define TRACE_COUNTER 'C'
+
+typedef struct TraceEvent {
+    const char *name;  //string literal, never freed
+    uint64_t start;    //monotonic ns
+    uint64_t duration;
+    int64_t value;
+    char phase;
+} TraceEvent;
+
+//written only by its own thread; head counts every event ever recorded
+typedef struct TraceRing {
+    TraceEvent events[TRACE_RING_SIZE];
+    std::atomic<uint64_t> head;
+    int thread_id;
+    std::string thread_name;
+} TraceRing;
+
+//texture memory the renderer holds, for the HUD
+typedef struct TextureStats {
+    std::atomic<int> count;
+    std::atomic<int64_t> bytes;
+} TextureStats;
+
+extern std::atomic<bool> trace_enabled;
+extern TextureStats texture_stats;
+
+void startTrace();
+void stopTrace();
+bool writeTrace(const std::string &path);
+void traceThreadName(const std::string &name);
+void traceComplete(const char *name, uint64_t start, uint64_t end, int64_t value);
+void traceCounter(const char *name, int64_t value);
+void countTexture(int width, int height, int sign);
+uint64_t traceClock();
+
+//records the enclosing block; value shows up as an argument of the event
+struct TraceScope {
+    const char *name;
+    uint64_t start;
+    int64_t value;
+
+    TraceScope(const char *name) : name(name), start(0), value(0)
+    {
+        if(trace_enabled.load(std::memory_order_relaxed))
+        {
+            start = traceClock();
+        }
+    }
+    ~TraceScope()
+    {
+        if(start != 0)
+        {
+            traceComplete(name, start, traceClock(), value);
+        }
+    }
+};
+
+#define TRACE_JOIN(a, b) a##b
+#define TRACE_NAME(line) TRACE_JOIN(trace_scope_, line)
+#define TRACE_SCOPE(name) TraceScope TRACE_NAME(__LINE__)(name)
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "threadpool.h"
+
+/*
+        Background copy, move and delete. Jobs run one after another on their
+        own small pool, so a long copy never holds up scans or filtering. A
+        job's first task walks the sources, creates directories and queues one
+        task per file, so the files of a tree are copied in parallel. File data
+        moves with copy_file_range [sendfile where that is not supported] and
+        never passes through user space. A move within one filesystem is a
+        rename. Progress lives in atomics the window reads each frame; workers
+        push a user event at most every TRANSFER_PROGRESS_MS to get it redrawn.
+
+        Cancelling stops every file between two chunks and removes the partly
+        written file; directories already created stay. A move across
+        filesystems only removes its sources when everything was copied.
+*/
+
+#define TRANSFER_COPY 0
+#define TRANSFER_MOVE 1
+#define TRANSFER_DELETE 2
+
+#define TRANSFER_THREADS 4
+//bytes per copy call; cancellation is checked between chunks
+#define TRANSFER_CHUNK (8*1024*1024)
+#define TRANSFER_PROGRESS_MS 100
+
+typedef struct TransferJob {
+    int operation;
+    std::vector<std::string> sources;
+    std::string destination;  //directory the sources go into [unused for deletes]
+    ThreadPool *pool;
+    Uint32 event_type;
+    Uint64 started;
+
+    //progress, written by the workers and read by the window
+    std::atomic<uint64_t> bytes_total;
+    std::atomic<uint64_t> bytes_done;
+    std::atomic<int> files_total;
+    std::atomic<int> files_done;
+    std::atomic<int> errors;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+    std::atomic<Uint32> last_notify;
+
+    //the planning task plus every file task not yet done; whichever brings it to zero finishes the job
+    std::atomic<int> outstanding;
+    TaskGroup group;
+
+    //guarded by lock: created directories and their own permissions, applied once their contents are in,
+    //and sources a cross-filesystem move removes at the end
+    std::mutex lock;
+    std::vector<std::pair<std::string, mode_t> > directories;
+    std::vector<std::string> moved;
+} TransferJob;
+
+typedef struct TransferQueue {
+    ThreadPool *pool;
+    std::deque<std::shared_ptr<TransferJob> > jobs;  //the front one is running
+    Uint32 event_type;
+} TransferQueue;
+
+void initializeTransfers(TransferQueue *queue, Uint32 event_type);
+void cleanTransfers(TransferQueue *queue);
+void queueTransfer(TransferQueue *queue, int operation, const std::vector<std::string> &sources, const std::string &destination);
+void cancelTransfers(TransferQueue *queue);
+bool updateTransfers(TransferQueue *queue, SDL_Event *event);
+std::string transferStatus(TransferQueue *queue);
+
+#endif
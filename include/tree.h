@@ -0,0 +1,33 @@
+#ifndef TREE_H
+#define TREE_H
+
+#include <vector>
+#include "entries.h"
+
+/*
+        Expand/collapse state of the listing. A directory whose children are in
+        the table is ENTRY_EXPANDED; collapsing it sets ENTRY_COLLAPSED and
+        hides the range of rows below it without touching the table. The view
+        keeps the outermost hidden ranges in order, so rows and entries convert
+        with a binary search over the ranges instead of a pass over the rows.
+*/
+
+typedef struct TreeView {
+    //hidden entries [start, end), outermost ranges only, in order
+    std::vector<int> hidden_start;
+    std::vector<int> hidden_end;
+    //entries hidden by the ranges before range k
+    std::vector<int> hidden_before;
+    int hidden;
+} TreeView;
+
+void resetTreeView(TreeView *view);
+void rebuildTreeView(TreeView *view, EntryTable *table);
+void collapseEntry(TreeView *view, EntryTable *table, int i);
+void uncollapseEntry(TreeView *view, EntryTable *table, int i);
+bool hasHiddenRows(TreeView *view);
+int visibleCount(TreeView *view, EntryTable *table);
+int visibleEntry(TreeView *view, int row);
+int visibleRow(TreeView *view, int i);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache.h"
+#include "threadpool.h"
+
+/*
+        Persistent index of a directory tree, stored as one flat binary file
+        and mapped read-only at startup. It holds the listing of every directory
+        the walker would descend into, together with the directory's stamp, so
+        the walker can serve any unchanged directory from the mapping after a
+        single statx. Stale directories are rescanned as usual.
+
+        A refresh walks the tree in the background, reusing every directory
+        whose stamp still matches, and writes a new file beside the old one.
+        The new file is renamed over the old one, so readers in this or any
+        other process see either the old index or the new one, never a partial
+        write. Mappings are reference counted and the old one is unmapped once
+        the last reader is done with it.
+
+        The index can also be searched without walking anything [--search]:
+        every name in the arena is matched like the filter box matches rows,
+        split over the thread pool, and matches come back as full paths.
+
+        Layout [native byte order, 8-byte aligned]:
+            IndexHeader
+            IndexDirectory[directory_count]  sorted by path
+            IndexEntry[entry_count]          grouped by directory, in listing order
+            char names[names_size]           directory paths and entry names
+*/
+
+#define INDEX_MAGIC "FXINDEX"
+#define INDEX_VERSION 1
+#define INDEX_BYTE_ORDER 0x01020304
+
+//index entries matched per pool task
+#define INDEX_SEARCH_CHUNK 65536
+
+typedef struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t directory_count;
+    uint64_t entry_count;
+    uint64_t names_size;
+    uint64_t file_size;
+} IndexHeader;
+
+typedef struct IndexDirectory {
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t entry_count;
+    uint64_t first_entry;
+} IndexDirectory;
+
+//entry flags
+#define INDEX_DIRECTORY 0x1
+#define INDEX_LINK 0x2
+
+typedef struct IndexEntry {
+    uint64_t size;
+    int64_t mtime;
+    uint32_t name_offset;
+    uint32_t mode;
+    uint32_t parent;  //directory the entry is listed in
+    uint16_t name_length;
+    uint8_t flags;
+    uint8_t unused;
+} IndexEntry;
+
+//a mapped index file
+typedef struct TreeIndex {
+    void *map;
+    size_t map_size;
+    const IndexHeader *header;
+    const IndexDirectory *directories;
+    const IndexEntry *entries;
+    const char *names;
+
+    ~TreeIndex();
+} TreeIndex;
+
+//background rebuild of the index file
+typedef struct IndexRefresh {
+    std::thread worker;
+    TaskGroup group;
+    std::atomic<bool> running;
+} IndexRefresh;
+
+std::string defaultIndexFile();
+std::shared_ptr<TreeIndex> openTreeIndex(const std::string &filename);
+bool lookupIndexedListing(TreeIndex *index, const std::string &dirname, const DirectoryStamp &stamp, std::vector<EntryMeta> *entries);
+std::vector<std::string> searchTreeIndex(TreeIndex *index, const std::string &query, bool fuzzy, size_t limit, ThreadPool *pool);
+void startIndexRefresh(IndexRefresh *refresh, const std::string &root, const std::string &filename, ThreadPool *pool, DirectoryCache *cache);
+void stopIndexRefresh(IndexRefresh *refresh);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef USAGE_H
+#define USAGE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "cache.h"
+#include "threadpool.h"
+
+/*
+        Disk usage aggregation, like du: the total size and file count under
+        each directory. Every directory is read on its own pool task and its
+        bytes are added to all of its ancestors right away, so totals grow
+        while the walk is still running. Files with several hard links are
+        counted once per (device, inode). Sizes are apparent sizes and the
+        walk stays on the filesystem it started on.
+
+        What a directory holds directly is cached under its device and inode
+        and reused while its mtime and ctime are unchanged, so walking an
+        unchanged tree again costs one statx per directory. A file that grows
+        in place leaves its directory's stamps alone, so whoever sees such a
+        change must forget that directory's record before walking again.
+*/
+
+//cached directory records before the cache is emptied
+#define USAGE_CACHE_LIMIT 262144
+
+typedef struct InodeKey {
+    uint64_t device;
+    uint64_t inode;
+    bool operator==(const struct InodeKey &other) const { return device == other.device && inode == other.inode; }
+} InodeKey;
+
+typedef struct InodeHash {
+    size_t operator()(const InodeKey &key) const { return std::hash<uint64_t>()(key.inode*31 + key.device); }
+} InodeHash;
+
+//a file with more than one link, counted by whichever directory reaches it first
+typedef struct HardLink {
+    InodeKey key;
+    uint64_t size;
+} HardLink;
+
+//what one directory holds directly
+typedef struct UsageRecord {
+    DirectoryStamp stamp;
+    uint64_t bytes;  //files with a single link
+    uint64_t files;
+    std::vector<std::string> subdirectories;
+    std::vector<HardLink> links;
+} UsageRecord;
+
+typedef struct UsageCache {
+    std::mutex lock;
+    std::unordered_map<InodeKey, UsageRecord, InodeHash> records;
+} UsageCache;
+
+//totals of a directory and everything below it
+typedef struct DirectoryUsage {
+    uint64_t bytes;
+    uint64_t files;
+    bool complete;
+} DirectoryUsage;
+
+typedef struct UsageNode {
+    std::string path;
+    uint64_t device;
+    struct UsageNode *parent;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> files;
+    std::atomic<int> pending;  //own read plus unfinished subdirectories
+} UsageNode;
+
+//called on a pool worker after each directory; finished is set once every total is complete
+typedef std::function<void(bool finished)> UsageEmitter;
+
+typedef struct UsageJob {
+    ThreadPool *pool;
+    TaskGroup group;
+    UsageCache *cache;
+    UsageEmitter emit;
+    std::atomic<int> remaining;  //roots still being walked
+
+    //nodes by path and links already counted, guarded by lock
+    std::mutex lock;
+    std::unordered_map<std::string, UsageNode*> nodes;
+    std::unordered_set<InodeKey, InodeHash> linked;
+
+    ~UsageJob();
+} UsageJob;
+
+void initializeUsageCache(UsageCache *cache);
+void forgetUsage(UsageCache *cache, const std::string &dirname);
+std::shared_ptr<UsageJob> startUsage(const std::vector<std::string> &directories, ThreadPool *pool, UsageCache *cache, UsageEmitter emit);
+void cancelUsage(UsageJob *job);
+bool getUsage(UsageJob *job, const std::string &path, DirectoryUsage *usage);
+bool isUsageFinished(UsageJob *job);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef WALK_H
+#define WALK_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "scan.h"
+#include "threadpool.h"
+#include "cache.h"
+
+/*
+        Recursive directory walker. Sibling directories are scanned concurrently
+        on the thread pool, while entries are emitted in the same pre-order the
+        single-threaded listing produced: every directory sorted
+        case-insensitively in natural order and followed directly by its own (sorted) contents.
+        Entries are handed out as soon as everything before them is known, so
+        the top of a listing is available long before the whole walk is done.
+
+        Scanning ahead of the emitter is bounded: once WALK_MAX_BUFFERED
+        scanned entries wait to be emitted, or WALK_MAX_SCANS scans are queued
+        or running, further subdirectories are held back unscanned. The one
+        the emitter needs next is always scanned, so a slow consumer slows the
+        walk down instead of making it buffer the whole tree.
+*/
+
+//no limit on how deep the walker descends
+#define WALK_UNLIMITED -1
+
+//scan-ahead limits
+#define WALK_MAX_BUFFERED (1 << 16)
+#define WALK_MAX_SCANS 256
+
+//one scanned directory and the subdirectories it was descended into
+typedef struct WalkNode {
+    std::string path;
+    int depth;
+    std::vector<EntryMeta> entries;
+    std::vector<struct WalkNode*> children;  //parallel to entries, NULL when not descended
+    ScanStats stats;
+    int error;
+    bool submitted;
+    bool ready;
+} WalkNode;
+
+//receives the next run of entries in pre-order; finished is set on the last call
+typedef std::function<void(std::vector<EntryMeta> *batch, bool finished)> WalkEmitter;
+
+typedef struct WalkJob {
+    ThreadPool *pool;
+    TaskGroup group;
+    int max_depth;
+    DirectoryCache *cache;
+    WalkEmitter emit;
+
+    //emission cursor and scan-ahead accounting, guarded by lock
+    std::mutex lock;
+    std::vector<std::pair<WalkNode*, int> > cursor;
+    ScanStats stats;
+    int buffered;                    //scanned entries not yet emitted
+    int scans;                       //scans queued or running
+    std::vector<WalkNode*> deferred; //subdirectories held back, the next one to scan last
+
+    ~WalkJob();
+} WalkJob;
+
+std::shared_ptr<WalkJob> startWalk(const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, WalkEmitter emit);
+void cancelWalk(WalkJob *job);
+std::vector<EntryMeta> walkDirectory(const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, ScanStats *stats);
+void sortEntries(std::vector<EntryMeta> *entries);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <SDL.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/*
+        inotify watcher for the directories on screen. A background thread reads
+        the inotify fd and records which paths changed; bursts are coalesced for
+        WATCH_COALESCE_MS before a single user event wakes the event loop, which
+        then re-stats only those paths and patches the listing.
+*/
+
+#define WATCH_COALESCE_MS 100
+
+typedef struct DirectoryWatch {
+    int inotify_fd;
+    int stop_fd;
+    std::thread reader;
+    Uint32 event_type;
+
+    //everything below is guarded by lock
+    std::mutex lock;
+    std::unordered_map<int, std::string> directories;  //watch descriptor -> path
+    std::set<std::string> changed;
+    bool overflowed;
+    bool notified;
+    bool limit_reported;
+} DirectoryWatch;
+
+bool startWatch(DirectoryWatch *watch, Uint32 event_type);
+void stopWatch(DirectoryWatch *watch);
+bool watchDirectory(DirectoryWatch *watch, const std::string &dirname);
+void clearWatches(DirectoryWatch *watch);
+bool takeChanges(DirectoryWatch *watch, std::set<std::string> *changed);
+
+#endif
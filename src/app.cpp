@@ -0,0 +1,1214 @@
+#include <iostream>
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include <set>
+#include <unordered_map>
+#include <cmath>
+#include "app.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+void initialize(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    TRACE_SCOPE("initialize");
+    // set color of background when erasing frame
+    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
+    initializeLayout(data_ptr);
+
+    //Get Directory files: the parent entry right away, the rest streams in from the background scan
+    std::string dir = data_ptr->directory;
+    clearEntryTable(&data_ptr->entries, dir);
+    resetSelection(&data_ptr->selection);
+    resetTreeView(&data_ptr->tree);
+    cancelExpansions(data_ptr);
+    std::vector<EntryMeta> entries(1);
+    entries.at(0) = {dir + "/..", 0, 0, 0, true, false};
+    statEntry(AT_FDCWD, entries.at(0).path.c_str(), &entries.at(0), NULL);
+    insertEntries(&entries, 0, data_ptr);
+
+    //totals of the previous directory are no longer wanted
+    cancelDirectorySizes(&data_ptr->sizes);
+
+    //watch before scanning so nothing that changes during the scan is missed
+    clearWatches(&data_ptr->watch);
+    watchDirectory(&data_ptr->watch, dir);
+
+    int depth = data_ptr->recursive_viewing_mode ? data_ptr->recursive_depth : 0;
+    data_ptr->scan_finished = false;
+    data_ptr->scan_started = SDL_GetPerformanceCounter();
+    data_ptr->scan_entries = 0;
+    data_ptr->scan_rate = 0;
+    startDirectoryScan(&data_ptr->scan, dir, depth, data_ptr->pool, &data_ptr->cache, data_ptr->scan_event);
+}
+
+void initializeLayout(AppData *data_ptr)
+{
+    //Create Header
+    data_ptr->header_box = {0,0,800,25};
+    int line_height = data_ptr->text.line_height;
+    //Set coordinates
+    int size_pos_x = 500;
+    int permissions_pos_x = 570;
+    data_ptr->name_header_coordinates = {50, 0, measureText(&data_ptr->text, "Name"), line_height};
+    data_ptr->size_header_coordinates = {size_pos_x, 0, measureText(&data_ptr->text, "Size"), line_height};
+    data_ptr->permissions_header_coordinates = {permissions_pos_x, 0, measureText(&data_ptr->text, "Permissions"), line_height};
+
+    //Create Recursive Mode Button
+    data_ptr->recursive_button_outline = {778,3,19,19};
+    data_ptr->recursive_button = {782,7,11,11};
+    data_ptr->button_text_coordinates = {705, 0, measureText(&data_ptr->text, "All Files:"), line_height};
+
+    //Create Filter Box [a new directory starts unfiltered]
+    data_ptr->filter_box = {250,3,230,19};
+    data_ptr->filter_text.clear();
+    resetFilter(&data_ptr->filter);
+
+
+    //every row is one line of text, so all rows share the same height
+    data_ptr->row_height = line_height;
+    data_ptr->scroll_offset = 0;
+    data_ptr->scroll_velocity = 0;
+    data_ptr->scroll_fraction = 0;
+
+    //Create Scrollbar [the thumb is sized and placed from the listing by updateScrollbar()]
+    data_ptr->scrollbar_outline = {2,27,21,571};
+    data_ptr->scrollbar = {7,SCROLL_TRACK_TOP,11,SCROLL_TRACK_LENGTH};
+    data_ptr->scrollbar_selected = false;
+}
+
+void insertEntries(std::vector<EntryMeta> *entries, int position, AppData *data_ptr)
+{
+    TraceScope scope("insertEntries");
+    scope.value = entries->size();
+
+    //classify once; everything else is formatted when the row is drawn
+    std::vector<uint8_t> icon_types(entries->size());
+    std::vector<int> expanded;
+    for(int i = 0; i < entries->size(); i++)
+    {
+        icon_types.at(i) = classifyEntry(&(entries->at(i)));
+
+        //in recursive mode every directory the walker descends into is watched too, and shows expanded
+        if(data_ptr->recursive_viewing_mode && isWatchedDirectory(&(entries->at(i)), data_ptr))
+        {
+            watchDirectory(&data_ptr->watch, entries->at(i).path);
+            expanded.push_back(position + i);
+        }
+    }
+    if(data_ptr->sniff_types)
+    {
+        sniffEntries(entries, &icon_types, data_ptr);
+    }
+    insertEntryRows(&data_ptr->entries, position, entries, &icon_types);
+    insertSelectionRows(&data_ptr->selection, position, entries->size());
+    for(int i = 0; i < expanded.size(); i++)
+    {
+        data_ptr->entries.flags.at(expanded.at(i)) |= ENTRY_EXPANDED;
+    }
+    if(hasHiddenRows(&data_ptr->tree))
+    {
+        rebuildTreeView(&data_ptr->tree, &data_ptr->entries);
+    }
+    data_ptr->filter.stale = true;
+    updateScrollbar(data_ptr);
+}
+
+void removeEntries(int position, int count, AppData *data_ptr)
+{
+    removeEntryRows(&data_ptr->entries, position, count);
+    removeSelectionRows(&data_ptr->selection, position, count);
+    if(hasHiddenRows(&data_ptr->tree))
+    {
+        rebuildTreeView(&data_ptr->tree, &data_ptr->entries);
+    }
+    data_ptr->filter.stale = true;
+    updateScrollbar(data_ptr);
+}
+
+void updateScrollbar(AppData *data_ptr)
+{
+    //the thumb is to the track what the window is to the listing
+    int view = HEIGHT - LIST_TOP;
+    int content = std::max(view, rowCount(data_ptr)*data_ptr->row_height);
+    int thumb = std::max(SCROLL_THUMB_MIN, (int)((long)SCROLL_TRACK_LENGTH*view/content));
+    data_ptr->scrollbar.h = std::min(thumb, SCROLL_TRACK_LENGTH);
+
+    //a shrinking listing pulls the view back inside it
+    int max_scroll = maxScroll(data_ptr);
+    data_ptr->scroll_offset = std::max(0, std::min(data_ptr->scroll_offset, max_scroll));
+    int travel = SCROLL_TRACK_LENGTH - data_ptr->scrollbar.h;
+    data_ptr->scrollbar.y = SCROLL_TRACK_TOP + (max_scroll > 0 ? (int)((long)travel*data_ptr->scroll_offset/max_scroll) : 0);
+}
+
+int maxScroll(AppData *data_ptr)
+{
+    return std::max(0, rowCount(data_ptr)*data_ptr->row_height - (HEIGHT - LIST_TOP));
+}
+
+void scrollTo(int offset, AppData *data_ptr)
+{
+    data_ptr->scroll_offset = offset;
+    updateScrollbar(data_ptr);
+}
+
+void scrollPage(int pages, AppData *data_ptr)
+{
+    //a page keeps one row of the previous view in sight
+    int page = std::max(1, (HEIGHT - LIST_TOP)/data_ptr->row_height - 1)*data_ptr->row_height;
+    data_ptr->scroll_velocity = 0;
+    scrollTo(data_ptr->scroll_offset + pages*page, data_ptr);
+}
+
+void dragScrollbar(int y, AppData *data_ptr)
+{
+    //the thumb follows the pointer and the offset is read back from where it sits on the track
+    int travel = SCROLL_TRACK_LENGTH - data_ptr->scrollbar.h;
+    int thumb_y = std::max(0, std::min(y - data_ptr->scrollbar_offset.y - SCROLL_TRACK_TOP, travel));
+    if(travel > 0)
+    {
+        scrollTo((int)((long)maxScroll(data_ptr)*thumb_y/travel), data_ptr);
+    }
+}
+
+void flingScroll(int notches, AppData *data_ptr)
+{
+    //each notch adds enough speed to coast WHEEL_ROWS rows, so quick turns build up momentum
+    data_ptr->scroll_velocity += -notches*WHEEL_ROWS*data_ptr->row_height*SCROLL_FRICTION;
+    data_ptr->scroll_time = SDL_GetTicks();
+}
+
+bool stepScroll(AppData *data_ptr)
+{
+    //advances a fling to now; false once it has come to rest
+    if(data_ptr->scroll_velocity == 0)
+    {
+        return false;
+    }
+    Uint32 now = SDL_GetTicks();
+    double seconds = std::min(0.1, (now - data_ptr->scroll_time)/1000.0);
+    data_ptr->scroll_time = now;
+
+    double moved = data_ptr->scroll_velocity*seconds + data_ptr->scroll_fraction;
+    int whole = (int)moved;
+    data_ptr->scroll_fraction = moved - whole;
+    data_ptr->scroll_velocity *= std::exp(-SCROLL_FRICTION*seconds);
+    scrollTo(data_ptr->scroll_offset + whole, data_ptr);
+
+    //slow speeds and the end it is heading for stop it
+    bool at_end = (data_ptr->scroll_velocity < 0) ? data_ptr->scroll_offset == 0 : data_ptr->scroll_offset == maxScroll(data_ptr);
+    if(std::fabs(data_ptr->scroll_velocity) < data_ptr->row_height || at_end)
+    {
+        data_ptr->scroll_velocity = 0;
+        data_ptr->scroll_fraction = 0;
+    }
+    return true;
+}
+
+void applyChanges(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    TRACE_SCOPE("applyChanges");
+    std::set<std::string> changed;
+    if(takeChanges(&data_ptr->watch, &changed))
+    {
+        //the kernel dropped events: only a rescan is reliable
+        cleanEntries(data_ptr);
+        initialize(renderer, data_ptr);
+        return;
+    }
+
+    //paths are sorted, so a new directory is handled before anything inside it
+    std::vector<std::string> walked;
+    for(std::set<std::string>::iterator it = changed.begin(); it != changed.end(); it++)
+    {
+        const std::string &path = *it;
+
+        //the contents of a directory created here come from its background walk
+        bool inside_walk = false;
+        for(int w = 0; w < walked.size(); w++)
+        {
+            inside_walk = inside_walk || path.compare(0, walked.at(w).length() + 1, walked.at(w) + "/") == 0;
+        }
+        if(inside_walk)
+        {
+            continue;
+        }
+
+        //locate the row [binary search only works while the listing is in path order]
+        bool listed;
+        bool path_order = isPathOrder(data_ptr->sort_order);
+        int position = path_order ? findEntry(&data_ptr->entries, path, &listed) : findEntryUnordered(&data_ptr->entries, path, &listed);
+
+        //a path's current state is all that matters, however many events it had
+        EntryMeta meta = {path, 0, 0, 0, false, false};
+        bool exists = statEntry(AT_FDCWD, path.c_str(), &meta, NULL);
+
+        //rows below a directory in recursive mode belong to its subtree
+        int subtree = listed ? subtreeSize(&data_ptr->entries, position) : 0;
+
+        if(!exists) {
+            //deleted or renamed away
+            if(listed)
+            {
+                removeEntries(position, 1 + subtree, data_ptr);
+            }
+        } else if(listed && meta.is_directory == (data_ptr->entries.icon_type.at(position) == 0)) {
+            //modified in place: refresh size, permissions and type of that row only
+            std::vector<EntryMeta> entries(1, meta);
+            std::vector<uint8_t> icon_types(1, classifyEntry(&meta));
+            if(data_ptr->sniff_types)
+            {
+                sniffEntries(&entries, &icon_types, data_ptr);
+            }
+            updateEntryRow(&data_ptr->entries, position, &meta, icon_types.at(0));
+        } else {
+            //created, renamed here, or changed between file and directory
+            if(listed)
+            {
+                removeEntries(position, 1 + subtree, data_ptr);
+            }
+            if(!path_order)
+            {
+                //goes at the end of its directory for now; the listing is re-sorted below
+                bool parent_listed;
+                std::string parent = path.substr(0, path.rfind('/'));
+                int parent_position = findEntryUnordered(&data_ptr->entries, parent, &parent_listed);
+                position = parent_listed ? parent_position + 1 + subtreeSize(&data_ptr->entries, parent_position) : entryCount(&data_ptr->entries);
+            }
+            std::vector<EntryMeta> entries(1, meta);
+            insertEntries(&entries, position, data_ptr);
+            if(data_ptr->recursive_viewing_mode && isWatchedDirectory(&meta, data_ptr))
+            {
+                //walked off the event loop [a whole tree may have been unpacked here]; its rows are
+                //spliced in below it as they arrive, like an expanded directory's
+                int depth = slashCount(path) - slashCount(data_ptr->directory);
+                int remaining = (data_ptr->recursive_depth == WALK_UNLIMITED) ? WALK_UNLIMITED : data_ptr->recursive_depth - depth;
+                startExpansion(path, remaining, data_ptr);
+                walked.push_back(path);
+            }
+        }
+    }
+    if(!changed.empty() && !isPathOrder(data_ptr->sort_order))
+    {
+        resortEntries(data_ptr);
+    }
+
+    //totals above a change are stale; unchanged directories come from the usage cache,
+    //except the parents of changed paths [a file written in place keeps its directory's stamps]
+    if(!changed.empty())
+    {
+        std::set<std::string> parents;
+        for(std::set<std::string>::iterator it = changed.begin(); it != changed.end(); it++)
+        {
+            parents.insert(it->substr(0, std::max<size_t>(it->rfind('/'), 1)));
+        }
+        for(std::set<std::string>::iterator it = parents.begin(); it != parents.end(); it++)
+        {
+            forgetUsage(&data_ptr->usage_cache, *it);
+        }
+        startSizes(data_ptr);
+    }
+}
+
+bool isWatchedDirectory(EntryMeta *meta, AppData *data_ptr)
+{
+    //matches what the walker descends into: real, visible directories within the depth limit
+    std::string file = meta->path.substr(meta->path.rfind('/') + 1);
+    if(!meta->is_directory || meta->is_link || file.at(0) == '.')
+    {
+        return false;
+    }
+    int depth = slashCount(meta->path) - slashCount(data_ptr->directory) - 1;
+    return data_ptr->recursive_depth == WALK_UNLIMITED || depth < data_ptr->recursive_depth;
+}
+
+void startSizes(AppData *data_ptr)
+{
+    //top-level directories only; totals of nested ones fall out of the same walk
+    EntryTable *table = &data_ptr->entries;
+    std::vector<std::string> directories;
+    for(int i = 1; i < entryCount(table); i++)
+    {
+        if((table->flags.at(i) & ENTRY_DIRECTORY) && !(table->flags.at(i) & ENTRY_LINK) && table->depth.at(i) == 0)
+        {
+            directories.push_back(entryPath(table, i));
+        }
+    }
+    startDirectorySizes(&data_ptr->sizes, directories, data_ptr->background, &data_ptr->usage_cache, data_ptr->sizes_event);
+}
+
+void sniffEntries(std::vector<EntryMeta> *entries, std::vector<uint8_t> *icon_types, AppData *data_ptr)
+{
+    //rows keep their name-based icon until the contents have been read off the event loop
+    std::vector<std::string> paths;
+    for(int i = 0; i < entries->size(); i++)
+    {
+        if(needsSniffing(&(entries->at(i)), icon_types->at(i)))
+        {
+            paths.push_back(entries->at(i).path);
+        }
+    }
+    if(!paths.empty())
+    {
+        queueSniffing(&data_ptr->sniffing, paths, data_ptr->pool);
+    }
+}
+
+bool applySniffedTypes(SDL_Event *event, AppData *data_ptr)
+{
+    if(!isCurrentSniffing(&data_ptr->sniffing, event))
+    {
+        return false;
+    }
+    TRACE_SCOPE("applySniffedTypes");
+    std::vector<std::pair<std::string, uint8_t> > types;
+    takeSniffedTypes(&data_ptr->sniffing, &types);
+
+    //rows that went away meanwhile are skipped; without path order one pass over the table beats a search per file
+    EntryTable *table = &data_ptr->entries;
+    if(isPathOrder(data_ptr->sort_order)) {
+        for(int t = 0; t < types.size(); t++)
+        {
+            bool found;
+            int position = findEntry(table, types.at(t).first, &found);
+            if(found && table->icon_type.at(position) == ICON_OTHER)
+            {
+                table->icon_type.at(position) = types.at(t).second;
+            }
+        }
+    } else {
+        std::unordered_map<std::string, uint8_t> by_path(types.begin(), types.end());
+        for(int i = 1; i < entryCount(table); i++)
+        {
+            if(table->icon_type.at(i) != ICON_OTHER)
+            {
+                continue;
+            }
+            std::unordered_map<std::string, uint8_t>::iterator found = by_path.find(entryPath(table, i));
+            if(found != by_path.end())
+            {
+                table->icon_type.at(i) = found->second;
+            }
+        }
+        if(data_ptr->sort_order.key == SORT_TYPE)
+        {
+            resortEntries(data_ptr);
+        }
+    }
+    return true;
+}
+
+void applySizes(AppData *data_ptr)
+{
+    TRACE_SCOPE("applySizes");
+    //copy the current totals into the size column of every listed directory
+    EntryTable *table = &data_ptr->entries;
+    for(int i = 1; i < entryCount(table); i++)
+    {
+        DirectoryUsage usage;
+        if((table->flags.at(i) & ENTRY_DIRECTORY) && getUsage(data_ptr->sizes.job.get(), entryPath(table, i), &usage))
+        {
+            table->size.at(i) = usage.bytes;
+            table->flags.at(i) |= ENTRY_SIZED;
+            if(usage.complete) {
+                table->flags.at(i) &= ~ENTRY_PARTIAL;
+            } else {
+                table->flags.at(i) |= ENTRY_PARTIAL;
+            }
+        }
+    }
+}
+
+void setSortOrder(int key, AppData *data_ptr)
+{
+    //same column reverses the order, a new column starts ascending
+    if(data_ptr->sort_order.key == key) {
+        data_ptr->sort_order.descending = !data_ptr->sort_order.descending;
+    } else {
+        data_ptr->sort_order = {key, false};
+    }
+
+    //rows are permuted in place from the stored columns, nothing is rescanned
+    resortEntries(data_ptr);
+}
+
+void resortEntries(AppData *data_ptr)
+{
+    //the selection moves with its entries
+    std::vector<int> order = sortEntryTable(&data_ptr->entries, data_ptr->sort_order, data_ptr->pool);
+    if(!order.empty())
+    {
+        permuteSelection(&data_ptr->selection, order);
+    }
+    if(hasHiddenRows(&data_ptr->tree))
+    {
+        rebuildTreeView(&data_ptr->tree, &data_ptr->entries);
+    }
+    data_ptr->filter.stale = true;
+}
+
+bool onRect(int x, int y, SDL_Rect *rect)
+{
+    return x >= rect->x && x <= rect->x + rect->w && y >= rect->y && y <= rect->y + rect->h;
+}
+
+int rowAt(int x, int y, AppData *data_ptr)
+{
+    //row index from the click position; -1 unless the click is on that row's icon or name
+    if(y < LIST_TOP)
+    {
+        return -1;
+    }
+    int row = (y - LIST_TOP + data_ptr->scroll_offset)/data_ptr->row_height;
+    if(y - LIST_TOP + data_ptr->scroll_offset < 0 || row >= rowCount(data_ptr))
+    {
+        return -1;
+    }
+
+    int i = rowEntry(row, data_ptr);
+    int icon_gap = 2;
+    int icon_x = ROW_LEFT + EXPANDER_WIDTH + rowIndent(i, data_ptr);
+    int name_x = icon_x + 25;
+    int name_w = measureText(&data_ptr->text, rowLabel(i, data_ptr).c_str());
+    bool on_icon = x >= icon_x + icon_gap && x <= icon_x + data_ptr->row_height - icon_gap;
+    bool on_name = x >= name_x && x <= name_x + name_w;
+    return (on_icon || on_name) ? row : -1;
+}
+
+int rowCount(AppData *data_ptr)
+{
+    if(isFiltering(&data_ptr->filter))
+    {
+        return data_ptr->filter.matches.size();
+    }
+    return visibleCount(&data_ptr->tree, &data_ptr->entries);
+}
+
+int rowEntry(int row, AppData *data_ptr)
+{
+    //entry shown in a row, or -1 for no row
+    if(row < 0)
+    {
+        return row;
+    }
+    if(!isFiltering(&data_ptr->filter))
+    {
+        return visibleEntry(&data_ptr->tree, row);
+    }
+    return data_ptr->filter.matches.at(row);
+}
+
+std::string rowLabel(int i, AppData *data_ptr)
+{
+    //filtered rows lose their indentation, so nested entries show their path below the listed directory
+    EntryTable *table = &data_ptr->entries;
+    if(isFiltering(&data_ptr->filter) && table->depth.at(i) > 0)
+    {
+        return entryPath(table, i).substr(table->root.length() + 1);
+    }
+    return entryName(table, i);
+}
+
+int entryRow(int i, AppData *data_ptr)
+{
+    //row showing an entry, or the row it would sit at when the filter hides it [matches are in listing order]
+    if(!isFiltering(&data_ptr->filter))
+    {
+        return visibleRow(&data_ptr->tree, i);
+    }
+    std::vector<int> *matches = &data_ptr->filter.matches;
+    if(data_ptr->filter.duplicates)
+    {
+        //group order; an entry in no group sits past the last row
+        return std::find(matches->begin(), matches->end(), i) - matches->begin();
+    }
+    return std::lower_bound(matches->begin(), matches->end(), i) - matches->begin();
+}
+
+void selectRow(int row, int mode, AppData *data_ptr)
+{
+    Selection *selection = &data_ptr->selection;
+    int i = rowEntry(row, data_ptr);
+    if(mode == SELECT_NONE) {
+        //cursor only
+    } else if(mode == SELECT_TOGGLE) {
+        setSelected(selection, i, !isSelected(selection, i));
+        selection->anchor = i;
+    } else if(mode == SELECT_EXTEND && selection->anchor >= 0) {
+        //everything between the anchor and this row, in row order
+        clearSelection(selection);
+        int first = std::min(entryRow(selection->anchor, data_ptr), row);
+        int last = std::min(std::max(entryRow(selection->anchor, data_ptr), row), rowCount(data_ptr) - 1);
+        if(!isFiltering(&data_ptr->filter) && !hasHiddenRows(&data_ptr->tree)) {
+            selectRange(selection, first, last, true);
+        } else {
+            for(int r = first; r <= last; r++)
+            {
+                setSelected(selection, rowEntry(r, data_ptr), true);
+            }
+        }
+    } else {
+        clearSelection(selection);
+        setSelected(selection, i, true);
+        selection->anchor = i;
+    }
+    selection->cursor = i;
+}
+
+void moveCursor(int rows, int mode, AppData *data_ptr)
+{
+    int count = rowCount(data_ptr);
+    if(count == 0)
+    {
+        return;
+    }
+    int cursor = data_ptr->selection.cursor;
+    int row = (cursor < 0) ? 0 : std::max(0, std::min(entryRow(cursor, data_ptr) + rows, count - 1));
+    selectRow(row, mode, data_ptr);
+    revealRow(row, data_ptr);
+}
+
+void selectAll(AppData *data_ptr)
+{
+    //every listed row: all entries, or only the visible ones while filtering or collapsed
+    if(!isFiltering(&data_ptr->filter) && !hasHiddenRows(&data_ptr->tree))
+    {
+        selectRange(&data_ptr->selection, 0, entryCount(&data_ptr->entries) - 1, true);
+        return;
+    }
+    for(int row = 0; row < rowCount(data_ptr); row++)
+    {
+        setSelected(&data_ptr->selection, rowEntry(row, data_ptr), true);
+    }
+}
+
+void revealRow(int row, AppData *data_ptr)
+{
+    //scroll just enough to bring the row fully into view
+    int top = row*data_ptr->row_height;
+    int bottom = top + data_ptr->row_height - (HEIGHT - LIST_TOP);
+    data_ptr->scroll_velocity = 0;
+    if(top < data_ptr->scroll_offset) {
+        scrollTo(top, data_ptr);
+    } else if(bottom > data_ptr->scroll_offset) {
+        scrollTo(bottom, data_ptr);
+    }
+}
+
+void openEntry(SDL_Renderer *renderer, int i, AppData *data_ptr)
+{
+    //if [i] is a directory
+    if(data_ptr->entries.icon_type.at(i) == 0)
+    {
+        data_ptr->directory = normalizeDirectory(entryPath(&data_ptr->entries, i));
+        cleanEntries(data_ptr);
+        initialize(renderer, data_ptr);
+    }
+    else //[i] is a not a directory
+    {
+        //a selected file opens with the rest of the selected files; the launcher queues them in batches
+        std::vector<int> files;
+        if(isSelected(&data_ptr->selection, i)) {
+            files = selectedEntries(&data_ptr->selection);
+        } else {
+            files.push_back(i);
+        }
+        for(int f = 0; f < files.size(); f++)
+        {
+            int entry = files.at(f);
+            if(entry > 0 && data_ptr->entries.icon_type.at(entry) != ICON_DIRECTORY)
+            {
+                launchFile(&data_ptr->launcher, entryPath(&data_ptr->entries, entry), data_ptr->entries.icon_type.at(entry));
+            }
+        }
+    }
+}
+
+std::string normalizeDirectory(const std::string &dir)
+{
+    //"/a/b/.." is stored as "/a", so the listing cache and the parent key see one name per directory
+    std::string normal = fs::path(dir).lexically_normal().string();
+    while(normal.length() > 1 && normal.back() == '/')
+    {
+        normal.pop_back();
+    }
+    return normal;
+}
+
+void openParent(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    //normalized, so a directory reached through ".." still goes up from where it really is
+    std::string dir = normalizeDirectory(data_ptr->directory);
+    std::string parent = normalizeDirectory(dir + "/..");
+    if(parent == dir || dir.empty() || dir.at(0) != '/')
+    {
+        return;
+    }
+    data_ptr->directory = parent;
+    cleanEntries(data_ptr);
+    initialize(renderer, data_ptr);
+}
+
+std::vector<std::string> selectedPaths(AppData *data_ptr)
+{
+    //selected entries, or the cursor entry; entries inside another selected directory go with it
+    std::vector<int> entries = selectedEntries(&data_ptr->selection);
+    if(entries.empty() && data_ptr->selection.cursor >= 0)
+    {
+        entries.push_back(data_ptr->selection.cursor);
+    }
+    std::vector<std::string> paths;
+    for(int i = 0; i < entries.size(); i++)
+    {
+        if(entries.at(i) > 0)
+        {
+            paths.push_back(entryPath(&data_ptr->entries, entries.at(i)));
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    std::vector<std::string> outermost;
+    for(int i = 0; i < paths.size(); i++)
+    {
+        const std::string &path = paths.at(i);
+        if(outermost.empty() || path.compare(0, outermost.back().length() + 1, outermost.back() + "/") != 0)
+        {
+            outermost.push_back(path);
+        }
+    }
+    return outermost;
+}
+
+void copySelection(int operation, AppData *data_ptr)
+{
+    data_ptr->clipboard = selectedPaths(data_ptr);
+    data_ptr->clipboard_operation = operation;
+}
+
+void pasteClipboard(AppData *data_ptr)
+{
+    //into the listed directory; the watcher brings the new entries in as they appear
+    if(data_ptr->clipboard.empty())
+    {
+        return;
+    }
+    queueTransfer(&data_ptr->transfers, data_ptr->clipboard_operation, data_ptr->clipboard, data_ptr->directory);
+    if(data_ptr->clipboard_operation == TRANSFER_MOVE)
+    {
+        data_ptr->clipboard.clear();
+    }
+}
+
+void deleteSelection(AppData *data_ptr)
+{
+    //the first Delete only asks; a second one in a row deletes
+    if(!data_ptr->delete_armed)
+    {
+        data_ptr->delete_armed = !selectedPaths(data_ptr).empty();
+        return;
+    }
+    data_ptr->delete_armed = false;
+    queueTransfer(&data_ptr->transfers, TRANSFER_DELETE, selectedPaths(data_ptr), "");
+}
+
+void toggleDuplicates(AppData *data_ptr)
+{
+    //leaves the duplicate view, or stops a search, or starts one over the loaded listing
+    if(data_ptr->filter.duplicates || isDuplicateSearchRunning(&data_ptr->duplicates))
+    {
+        cancelDuplicateSearch(&data_ptr->duplicates);
+        data_ptr->filter.duplicates = false;
+    }
+    else
+    {
+        startDuplicateSearch(&data_ptr->duplicates, &data_ptr->entries, data_ptr->background);
+    }
+    data_ptr->filter.stale = true;
+    data_ptr->scroll_offset = 0;
+}
+
+bool applyDuplicates(SDL_Event *event, AppData *data_ptr)
+{
+    //progress only needs a redraw; a finished search tags the files and switches the rows to the groups
+    if(!isCurrentDuplicates(&data_ptr->duplicates, event))
+    {
+        return false;
+    }
+    if(!isDuplicateSearchRunning(&data_ptr->duplicates) && !data_ptr->filter.duplicates)
+    {
+        markDuplicates(&data_ptr->duplicates, &data_ptr->entries);
+        data_ptr->filter.duplicates = true;
+        data_ptr->filter.stale = true;
+        data_ptr->scroll_offset = 0;
+    }
+    return true;
+}
+
+int rowIndent(int i, AppData *data_ptr)
+{
+    //filtered rows are flat; otherwise each level of the tree indents by the stored depth
+    return isFiltering(&data_ptr->filter) ? 0 : INDENT*data_ptr->entries.depth.at(i);
+}
+
+int expanderAt(int x, int y, AppData *data_ptr)
+{
+    //directory whose expander is under the position, or -1
+    int offset = y - LIST_TOP + data_ptr->scroll_offset;
+    if(y < LIST_TOP || offset < 0 || isFiltering(&data_ptr->filter))
+    {
+        return -1;
+    }
+    int row = offset/data_ptr->row_height;
+    if(row >= rowCount(data_ptr))
+    {
+        return -1;
+    }
+    int i = rowEntry(row, data_ptr);
+    int expander_x = ROW_LEFT + rowIndent(i, data_ptr);
+    bool on_expander = x >= expander_x && x < expander_x + EXPANDER_WIDTH;
+    return (i > 0 && (data_ptr->entries.flags.at(i) & ENTRY_DIRECTORY) && on_expander) ? i : -1;
+}
+
+void toggleEntry(int i, AppData *data_ptr)
+{
+    EntryTable *table = &data_ptr->entries;
+    uint8_t flags = table->flags.at(i);
+    if(!(flags & ENTRY_EXPANDED)) {
+        //first expansion: scan just this directory and splice its rows in as they arrive
+        std::string path = entryPath(table, i);
+        table->flags.at(i) |= ENTRY_EXPANDED;
+        watchDirectory(&data_ptr->watch, path);
+        startExpansion(path, 0, data_ptr);
+    } else if(flags & ENTRY_COLLAPSED) {
+        uncollapseEntry(&data_ptr->tree, table, i);
+    } else {
+        collapseEntry(&data_ptr->tree, table, i);
+    }
+    updateScrollbar(data_ptr);
+}
+
+void expandCursor(bool expand, AppData *data_ptr)
+{
+    //Right opens the cursor directory, Left closes it or moves to its parent
+    int i = data_ptr->selection.cursor;
+    if(i <= 0 || isFiltering(&data_ptr->filter))
+    {
+        return;
+    }
+    EntryTable *table = &data_ptr->entries;
+    uint8_t flags = table->flags.at(i);
+    bool open = (flags & ENTRY_EXPANDED) && !(flags & ENTRY_COLLAPSED);
+    if(flags & ENTRY_DIRECTORY && open != expand)
+    {
+        toggleEntry(i, data_ptr);
+        return;
+    }
+    if(!expand && table->depth.at(i) > 0)
+    {
+        std::string path = entryPath(table, i);
+        bool found;
+        std::string parent = path.substr(0, path.rfind('/'));
+        int position = isPathOrder(data_ptr->sort_order) ? findEntry(table, parent, &found) : findEntryUnordered(table, parent, &found);
+        if(found)
+        {
+            int row = entryRow(position, data_ptr);
+            selectRow(row, SELECT_ONLY, data_ptr);
+            revealRow(row, data_ptr);
+        }
+    }
+}
+
+void startExpansion(const std::string &path, int max_depth, AppData *data_ptr)
+{
+    //the directory's row must be ENTRY_EXPANDED; applyExpansion() inserts what the scan finds
+    DirectoryScan *scan = &data_ptr->expansions[path];
+    scan->generation = data_ptr->expand_generation;
+    startDirectoryScan(scan, path, max_depth, data_ptr->pool, &data_ptr->cache, data_ptr->expand_event);
+    data_ptr->expand_generation = scan->generation;
+}
+
+bool applyExpansion(SDL_Renderer *renderer, SDL_Event *event, AppData *data_ptr)
+{
+    std::map<std::string, DirectoryScan>::iterator it = data_ptr->expansions.begin();
+    while(it != data_ptr->expansions.end() && !isCurrentScan(&it->second, event))
+    {
+        it++;
+    }
+    if(it == data_ptr->expansions.end())
+    {
+        return false;
+    }
+
+    //children go after the directory and whatever of its subtree arrived before them
+    std::vector<EntryMeta> entries;
+    bool finished = takeScanResults(&it->second, &entries);
+    EntryTable *table = &data_ptr->entries;
+    bool found;
+    int position = isPathOrder(data_ptr->sort_order) ? findEntry(table, it->first, &found) : findEntryUnordered(table, it->first, &found);
+    if(!found || !(table->flags.at(position) & ENTRY_EXPANDED))
+    {
+        //the directory went away meanwhile
+        cancelDirectoryScan(&it->second);
+        data_ptr->expansions.erase(it);
+        return true;
+    }
+    insertEntries(&entries, position + 1 + subtreeSize(table, position), data_ptr);
+
+    //changes held back while loading are applied on top, like after a directory scan
+    if(finished)
+    {
+        data_ptr->expansions.erase(it);
+        if(!isPathOrder(data_ptr->sort_order))
+        {
+            resortEntries(data_ptr);
+        }
+        if(data_ptr->expansions.empty() && data_ptr->scan_finished)
+        {
+            applyChanges(renderer, data_ptr);
+        }
+    }
+    return true;
+}
+
+void cancelExpansions(AppData *data_ptr)
+{
+    for(std::map<std::string, DirectoryScan>::iterator it = data_ptr->expansions.begin(); it != data_ptr->expansions.end(); it++)
+    {
+        cancelDirectoryScan(&it->second);
+    }
+    data_ptr->expansions.clear();
+}
+
+void setFilterText(const std::string &text, bool fuzzy, AppData *data_ptr)
+{
+    //each keystroke narrows the previous matches when it can; the view starts over at the top
+    data_ptr->filter_text = text;
+    setFilterQuery(&data_ptr->filter, &data_ptr->entries, text, fuzzy, data_ptr->pool);
+    data_ptr->scroll_velocity = 0;
+    scrollTo(0, data_ptr);
+}
+
+void render(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    TRACE_SCOPE("render");
+    Uint64 frame_start = SDL_GetPerformanceCounter();
+    if(data_ptr->thumbnails)
+    {
+        beginThumbnailFrame(&data_ptr->thumbs);
+    }
+
+    // erase renderer content
+    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
+    SDL_RenderClear(renderer);
+
+
+    //Draw
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &data_ptr->scrollbar_outline);
+    SDL_RenderFillRect(renderer, &data_ptr->scrollbar);
+
+    
+    
+    //only rows intersecting the window (plus overscan) are drawn
+    EntryTable *table = &data_ptr->entries;
+    int row_height = data_ptr->row_height;
+    int count = rowCount(data_ptr);
+    bool filtering = isFiltering(&data_ptr->filter);
+    int first = std::max(0, data_ptr->scroll_offset/row_height - ROW_OVERSCAN);
+    int last = std::min(count, (data_ptr->scroll_offset + HEIGHT - LIST_TOP)/row_height + 1 + ROW_OVERSCAN);
+    int size_pos_x = data_ptr->size_header_coordinates.x;
+    int permissions_pos_x = data_ptr->permissions_header_coordinates.x;
+    int icon_gap = 2;
+    SDL_Color phrase_color = { 0, 0, 0, 255 };
+    uint64_t rows_start = trace_enabled ? traceClock() : 0;
+    //rows only queue their parts here; each kind is then drawn with one call [or one per thumbnail]
+    std::vector<SDL_Rect> group_boxes;
+    std::vector<SDL_Rect> selected_boxes;
+    std::vector<std::pair<SDL_Texture*, SDL_Rect> > thumbnails;
+    SDL_Rect cursor_box = {0, 0, 0, 0};
+    std::vector<SDL_Vertex> expanders;
+    for(int row = first; row < last; row++) {
+        int y = LIST_TOP + row*row_height - data_ptr->scroll_offset;
+        int i = rowEntry(row, data_ptr);
+
+        //selected rows are shaded, the cursor row is outlined; duplicate groups alternate their background
+        SDL_Rect row_box = {ROW_LEFT, y, WIDTH - ROW_LEFT, row_height};
+        if(data_ptr->filter.duplicates && table->duplicate_group.at(i) % 2 == 1)
+        {
+            group_boxes.push_back(row_box);
+        }
+        if(isSelected(&data_ptr->selection, i))
+        {
+            selected_boxes.push_back(row_box);
+        }
+        if(i == data_ptr->selection.cursor)
+        {
+            cursor_box = row_box;
+        }
+
+        //determine correct folder type
+        int icon_x = ROW_LEFT + EXPANDER_WIDTH + rowIndent(i, data_ptr);
+
+        //expander: points right while the children are not shown, down once they are
+        uint8_t flags = table->flags.at(i);
+        if(i > 0 && (flags & ENTRY_DIRECTORY) && !filtering)
+        {
+            float x = icon_x - EXPANDER_WIDTH + 2;
+            float mid = y + row_height/2.0f;
+            bool open = (flags & ENTRY_EXPANDED) && !(flags & ENTRY_COLLAPSED);
+            SDL_Color expander_color = { 90, 90, 90, 255 };
+            if(open) {
+                expanders.push_back({{x, mid - 3}, expander_color, {0, 0}});
+                expanders.push_back({{x + 8, mid - 3}, expander_color, {0, 0}});
+                expanders.push_back({{x + 4, mid + 3}, expander_color, {0, 0}});
+            } else {
+                expanders.push_back({{x + 1, mid - 4}, expander_color, {0, 0}});
+                expanders.push_back({{x + 7, mid}, expander_color, {0, 0}});
+                expanders.push_back({{x + 1, mid + 4}, expander_color, {0, 0}});
+            }
+        }
+
+        SDL_Rect icon_pos = {icon_x + icon_gap, y + icon_gap, row_height - icon_gap*2, row_height - icon_gap*2};
+        //thumbnails are asked for on every row in or near the view, and drawn once they have arrived
+        SDL_Texture *thumbnail = NULL;
+        int thumb_w, thumb_h;
+        if(data_ptr->thumbnails && table->icon_type.at(i) == ICON_IMAGE)
+        {
+            thumbnail = findThumbnail(&data_ptr->thumbs, entryPath(table, i), table->mtime.at(i), table->size.at(i), &thumb_w, &thumb_h);
+        }
+        if(thumbnail != NULL) {
+            int longest = std::max(thumb_w, thumb_h);
+            SDL_Rect fit = {0, 0, icon_pos.w*thumb_w/longest, icon_pos.h*thumb_h/longest};
+            fit.x = icon_pos.x + (icon_pos.w - fit.w)/2;
+            fit.y = icon_pos.y + (icon_pos.h - fit.h)/2;
+            thumbnails.push_back(std::make_pair(thumbnail, fit));
+        } else {
+            queueIcon(&data_ptr->icons, table->icon_type.at(i), &icon_pos);
+        }
+
+        //display strings are only formatted for visible rows
+        std::string name = rowLabel(i, data_ptr);
+        std::string size = formatSize(table->size.at(i));
+        if(table->icon_type.at(i) == 0)
+        {
+            //directories show their total once known, marked while it is still growing
+            size = !(flags & ENTRY_SIZED) ? "-" : (flags & ENTRY_PARTIAL) ? size + "\u2026" : size;
+        }
+        std::string permissions = getPermissions(fs::perms(table->mode.at(i) & 0777));
+        queueText(&data_ptr->text, name.c_str(), icon_x + 25, y, phrase_color);
+        queueText(&data_ptr->text, size.c_str(), size_pos_x, y, phrase_color);
+        queueText(&data_ptr->text, permissions.c_str(), permissions_pos_x, y, phrase_color);
+    }
+    if(!group_boxes.empty())
+    {
+        SDL_SetRenderDrawColor(renderer, 238, 238, 238, 255);
+        SDL_RenderFillRects(renderer, group_boxes.data(), group_boxes.size());
+    }
+    if(!selected_boxes.empty())
+    {
+        SDL_SetRenderDrawColor(renderer, 200, 220, 250, 255);
+        SDL_RenderFillRects(renderer, selected_boxes.data(), selected_boxes.size());
+    }
+    if(cursor_box.w > 0)
+    {
+        SDL_SetRenderDrawColor(renderer, 90, 130, 200, 255);
+        SDL_RenderDrawRect(renderer, &cursor_box);
+    }
+    flushIcons(&data_ptr->icons);
+    for(int i = 0; i < thumbnails.size(); i++)
+    {
+        SDL_RenderCopy(renderer, thumbnails.at(i).first, NULL, &thumbnails.at(i).second);
+    }
+    flushText(&data_ptr->text);
+    if(!expanders.empty())
+    {
+        SDL_RenderGeometry(renderer, NULL, expanders.data(), expanders.size(), NULL, 0);
+    }
+    if(rows_start != 0)
+    {
+        traceComplete("render rows", rows_start, traceClock(), last - first);
+    }
+
+    //Header
+    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
+    SDL_RenderFillRect(renderer, &data_ptr->header_box);
+    queueText(&data_ptr->text, "Name", data_ptr->name_header_coordinates.x, data_ptr->name_header_coordinates.y, phrase_color);
+    queueText(&data_ptr->text, "Size", data_ptr->size_header_coordinates.x, data_ptr->size_header_coordinates.y, phrase_color);
+    queueText(&data_ptr->text, "Permissions", data_ptr->permissions_header_coordinates.x, data_ptr->permissions_header_coordinates.y, phrase_color);
+    queueText(&data_ptr->text, "All Files:", data_ptr->button_text_coordinates.x, data_ptr->button_text_coordinates.y, phrase_color);
+
+    //sort indicator: a small triangle after the sorted column, pointing up when ascending
+    //[type and modification time have no column, they are labelled next to Name]
+    int key = data_ptr->sort_order.key;
+    SDL_Rect *sorted_header = &data_ptr->name_header_coordinates;
+    if(key == SORT_SIZE) {
+        sorted_header = &data_ptr->size_header_coordinates;
+    } else if(key == SORT_PERMISSIONS) {
+        sorted_header = &data_ptr->permissions_header_coordinates;
+    }
+    float arrow_x = sorted_header->x + sorted_header->w + 4;
+    float arrow_mid = sorted_header->y + sorted_header->h/2.0f;
+    if(key == SORT_TYPE || key == SORT_MTIME)
+    {
+        queueText(&data_ptr->text, (key == SORT_TYPE) ? "(type)" : "(modified)", arrow_x + 12, sorted_header->y, phrase_color);
+    }
+
+    //filter text, or a grey hint while empty [the front of a long query is cut off so its end stays visible]
+    SDL_Rect *filter_box = &data_ptr->filter_box;
+    SDL_Color hint_color = { 140, 140, 140, 255 };
+    const char *filter_text = data_ptr->filter_text.c_str();
+    int tag_width = data_ptr->filter.fuzzy ? measureText(&data_ptr->text, "fuzzy") + 4 : 0;
+    while(measureText(&data_ptr->text, filter_text) > filter_box->w - 8 - tag_width)
+    {
+        nextCodePoint(&filter_text);
+    }
+    int caret_x = filter_box->x + 4;
+    if(data_ptr->filter_text.empty() && !data_ptr->filter_focused) {
+        queueText(&data_ptr->text, "Filter", caret_x, 0, hint_color);
+    } else {
+        caret_x += queueText(&data_ptr->text, filter_text, caret_x, 0, phrase_color);
+    }
+    if(data_ptr->filter.fuzzy)
+    {
+        queueText(&data_ptr->text, "fuzzy", filter_box->x + filter_box->w - tag_width, 0, hint_color);
+    }
+    flushText(&data_ptr->text);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, filter_box);
+    if(data_ptr->filter_focused)
+    {
+        SDL_RenderDrawLine(renderer, caret_x, filter_box->y + 3, caret_x, filter_box->y + filter_box->h - 4);
+    }
+
+    float tip = data_ptr->sort_order.descending ? 4 : -4;
+    SDL_Vertex arrow[3] = {
+        {{arrow_x, arrow_mid - tip}, phrase_color, {0, 0}},
+        {{arrow_x + 8, arrow_mid - tip}, phrase_color, {0, 0}},
+        {{arrow_x + 4, arrow_mid + tip}, phrase_color, {0, 0}}
+    };
+    SDL_RenderGeometry(renderer, NULL, arrow, 3, NULL, 0);
+
+    //Recursive Button
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, &data_ptr->recursive_button_outline);
+    if(data_ptr->recursive_viewing_mode) {
+        SDL_RenderFillRect(renderer, &data_ptr->recursive_button);
+    }
+
+    renderStatus(renderer, data_ptr);
+    if(data_ptr->hud_visible)
+    {
+        renderHud(renderer, data_ptr);
+    }
+
+    //time spent drawing, smoothed so the overlay stays readable [presenting may wait for vsync, so it is left out]
+    double frame_ms = (SDL_GetPerformanceCounter() - frame_start)*1000.0/SDL_GetPerformanceFrequency();
+    data_ptr->frame_ms = (data_ptr->frame_ms == 0) ? frame_ms : data_ptr->frame_ms*0.9 + frame_ms*0.1;
+
+    // show rendered frame
+    {
+        TRACE_SCOPE("SDL_RenderPresent");
+        SDL_RenderPresent(renderer);
+    }
+}
+
+void renderHud(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    char lines[3][64];
+    snprintf(lines[0], sizeof(lines[0]), "frame %.2f ms", data_ptr->frame_ms);
+    snprintf(lines[1], sizeof(lines[1]), "scan %.0f entries/s", data_ptr->scan_rate);
+    snprintf(lines[2], sizeof(lines[2]), "textures %d, %s", (int)texture_stats.count, formatSize(texture_stats.bytes).c_str());
+
+    int line_height = data_ptr->text.line_height;
+    SDL_Rect box = {WIDTH - 230, HEIGHT - 3*line_height - 10, 220, 3*line_height + 6};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 190);
+    SDL_RenderFillRect(renderer, &box);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_Color hud_color = { 255, 255, 255, 255 };
+    for(int i = 0; i < 3; i++)
+    {
+        queueText(&data_ptr->text, lines[i], box.x + 6, box.y + 3 + i*line_height, hud_color);
+    }
+    flushText(&data_ptr->text);
+}
+
+void renderStatus(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    //status strip along the bottom while a transfer or duplicate search runs, or a delete waits for confirmation
+    std::string status = transferStatus(&data_ptr->transfers);
+    if(status.empty())
+    {
+        status = duplicateStatus(&data_ptr->duplicates);
+    }
+    if(data_ptr->delete_armed)
+    {
+        int count = selectedPaths(data_ptr).size();
+        status = "Delete " + std::to_string(count) + (count == 1 ? " entry" : " entries") + " permanently? Delete again to confirm";
+    }
+    if(status.empty())
+    {
+        return;
+    }
+    int line_height = data_ptr->text.line_height;
+    SDL_Rect strip = {0, HEIGHT - line_height - 6, WIDTH, line_height + 6};
+    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
+    SDL_RenderFillRect(renderer, &strip);
+    SDL_Color status_color = { 255, 255, 255, 255 };
+    queueText(&data_ptr->text, status.c_str(), strip.x + 6, strip.y + 3, status_color);
+    flushText(&data_ptr->text);
+}
+
+void countScanned(int entries, AppData *data_ptr)
+{
+    //entries per second since the scan started, frozen once it finishes
+    data_ptr->scan_entries += entries;
+    double seconds = (double)(SDL_GetPerformanceCounter() - data_ptr->scan_started)/SDL_GetPerformanceFrequency();
+    if(seconds > 0)
+    {
+        data_ptr->scan_rate = data_ptr->scan_entries/seconds;
+    }
+    traceCounter("scanned entries", data_ptr->scan_entries);
+}
+
+void cleanEntries(AppData *data_ptr)
+{
+    //entry table
+    clearEntryTable(&data_ptr->entries, data_ptr->directory);
+    cancelSniffing(&data_ptr->sniffing);
+    cancelDuplicateSearch(&data_ptr->duplicates);
+    data_ptr->filter.duplicates = false;
+    resetSelection(&data_ptr->selection);
+    resetTreeView(&data_ptr->tree);
+}
+
+void cleanIcons(AppData *data_ptr)
+{
+    cleanIconAtlas(&data_ptr->icons);
+}
+
+void initializeIcons(SDL_Renderer *renderer, AppData *data_ptr)
+{
+    //all six icons share one texture, so a frame draws them with a single call
+    initializeIconAtlas(renderer, &data_ptr->icons);
+}
+
+int slashCount(std::string path)
+{
+    char slash = '/';
+    int slash_count = 0;
+
+    for (int i = 0; (i = path.find(slash, i)) != std::string::npos; i++) {
+        slash_count++;
+    }
+
+    return slash_count;
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "cache.h"
+#include "treeindex.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+void evictListings(DirectoryCache *cache);
+
+void initializeDirectoryCache(DirectoryCache *cache, size_t budget)
+{
+    cache->budget = budget;
+    cache->used = 0;
+    cache->hits = 0;
+    cache->index_hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->lru.clear();
+    cache->index.clear();
+}
+
+bool stampDirectory(const std::string &dirname, DirectoryStamp *stamp)
+{
+#ifdef STATX_TYPE
+    struct statx info;
+    if(statx(AT_FDCWD, dirname.c_str(), AT_STATX_SYNC_AS_STAT, STATX_INO | STATX_MTIME | STATX_CTIME, &info) != 0)
+    {
+        return false;
+    }
+    stamp->device = ((uint64_t)info.stx_dev_major << 32) | info.stx_dev_minor;
+    stamp->inode = info.stx_ino;
+    stamp->mtime_ns = info.stx_mtime.tv_sec*1000000000LL + info.stx_mtime.tv_nsec;
+    stamp->ctime_ns = info.stx_ctime.tv_sec*1000000000LL + info.stx_ctime.tv_nsec;
+#else
+    struct stat info;
+    if(stat(dirname.c_str(), &info) != 0)
+    {
+        return false;
+    }
+    stamp->device = info.st_dev;
+    stamp->inode = info.st_ino;
+    stamp->mtime_ns = info.st_mtim.tv_sec*1000000000LL + info.st_mtim.tv_nsec;
+    stamp->ctime_ns = info.st_ctim.tv_sec*1000000000LL + info.st_ctim.tv_nsec;
+#endif
+    return true;
+}
+
+bool lookupListing(DirectoryCache *cache, const std::string &dirname, const DirectoryStamp &stamp, std::vector<EntryMeta> *entries)
+{
+    std::shared_ptr<TreeIndex> tree;
+    {
+        std::lock_guard<std::mutex> guard(cache->lock);
+        std::unordered_map<std::string, std::list<CachedListing>::iterator>::iterator found = cache->index.find(dirname);
+        if(found != cache->index.end())
+        {
+            //a changed directory invalidates its listing
+            CachedListing *listing = &(*found->second);
+            if(listing->stamp.device == stamp.device && listing->stamp.inode == stamp.inode &&
+               listing->stamp.mtime_ns == stamp.mtime_ns && listing->stamp.ctime_ns == stamp.ctime_ns)
+            {
+                cache->lru.splice(cache->lru.begin(), cache->lru, found->second);
+                *entries = listing->entries;
+                cache->hits++;
+                return true;
+            }
+            cache->used -= listing->bytes;
+            cache->lru.erase(found->second);
+            cache->index.erase(found);
+        }
+        tree = cache->tree;
+    }
+
+    //the mapping is read outside the lock; the reference keeps it mapped meanwhile
+    bool indexed = tree && lookupIndexedListing(tree.get(), dirname, stamp, entries);
+    std::lock_guard<std::mutex> guard(cache->lock);
+    if(indexed) {
+        cache->index_hits++;
+    } else {
+        cache->misses++;
+    }
+    return indexed;
+}
+
+void storeListing(DirectoryCache *cache, const std::string &dirname, const DirectoryStamp &stamp, const std::vector<EntryMeta> &entries)
+{
+    //rough footprint: records, their name buffers, and the key
+    size_t bytes = sizeof(CachedListing) + dirname.capacity() + entries.size()*sizeof(EntryMeta);
+    for(int i = 0; i < entries.size(); i++)
+    {
+        bytes += entries.at(i).path.capacity();
+    }
+
+    std::lock_guard<std::mutex> guard(cache->lock);
+    if(bytes > cache->budget)
+    {
+        return;
+    }
+    std::unordered_map<std::string, std::list<CachedListing>::iterator>::iterator found = cache->index.find(dirname);
+    if(found != cache->index.end())
+    {
+        cache->used -= found->second->bytes;
+        cache->lru.erase(found->second);
+        cache->index.erase(found);
+    }
+
+    cache->lru.push_front({dirname, stamp, entries, bytes});
+    cache->index[dirname] = cache->lru.begin();
+    cache->used += bytes;
+    evictListings(cache);
+}
+
+CacheStats getCacheStats(DirectoryCache *cache)
+{
+    std::lock_guard<std::mutex> guard(cache->lock);
+    CacheStats stats = {cache->hits, cache->index_hits, cache->misses, cache->evictions, cache->used, cache->lru.size()};
+    return stats;
+}
+
+void setCacheTree(DirectoryCache *cache, std::shared_ptr<TreeIndex> tree)
+{
+    //readers still holding the old mapping keep it until they finish
+    std::lock_guard<std::mutex> guard(cache->lock);
+    cache->tree = tree;
+}
+
+std::shared_ptr<TreeIndex> getCacheTree(DirectoryCache *cache)
+{
+    std::lock_guard<std::mutex> guard(cache->lock);
+    return cache->tree;
+}
+
+void evictListings(DirectoryCache *cache)
+{
+    //least recently used listings go first
+    while(cache->used > cache->budget && !cache->lru.empty())
+    {
+        CachedListing *oldest = &cache->lru.back();
+        cache->used -= oldest->bytes;
+        cache->index.erase(oldest->path);
+        cache->lru.pop_back();
+        cache->evictions++;
+    }
+}
@@ -0,0 +1,488 @@
+#include "duplicates.h"
+#include "trace.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <string.h>
+
+//two independent 64-bit lanes over 8-byte words; with the exact size as well, a false match is not a practical concern
+typedef struct ContentHash {
+    uint64_t a;
+    uint64_t b;
+} ContentHash;
+
+void findDuplicates(std::shared_ptr<DuplicateJob> job, ThreadPool *pool);
+void hashFiles(std::shared_ptr<DuplicateJob> job, ThreadPool *pool, const std::vector<int> &files, int stage);
+bool statLinks(DuplicateFile *file);
+std::vector<int> foldLinks(DuplicateJob *job, std::vector<int> candidates);
+bool hashEdges(DuplicateJob *job, DuplicateFile *file);
+bool hashWhole(DuplicateJob *job, DuplicateFile *file);
+std::vector<std::vector<int> > collidingRuns(DuplicateJob *job, std::vector<int> candidates);
+void notifyDuplicates(DuplicateJob *job, bool force);
+void hashBytes(ContentHash *hash, const unsigned char *data, size_t length);
+void finishHash(ContentHash *hash, uint64_t length, uint64_t *out);
+
+void startDuplicateSearch(DuplicateSearch *search, EntryTable *table, ThreadPool *pool)
+{
+    TRACE_SCOPE("startDuplicateSearch");
+    cancelDuplicateSearch(search);
+    search->generation++;
+
+    //stage 0, from the size column alone: only files that share their exact size can be duplicates
+    std::vector<std::pair<uint64_t, int> > sized;
+    uint64_t bytes_listed = 0;
+    for(int i = 1; i < entryCount(table); i++)
+    {
+        if(!(table->flags.at(i) & (ENTRY_DIRECTORY | ENTRY_LINK)) && S_ISREG(table->mode.at(i)) && table->size.at(i) > 0)
+        {
+            sized.push_back(std::make_pair(table->size.at(i), i));
+            bytes_listed += table->size.at(i);
+        }
+    }
+    std::sort(sized.begin(), sized.end());
+
+    std::shared_ptr<DuplicateJob> job = std::make_shared<DuplicateJob>();
+    for(int start = 0; start < sized.size(); )
+    {
+        int end = start + 1;
+        while(end < sized.size() && sized.at(end).first == sized.at(start).first)
+        {
+            end++;
+        }
+        for(int i = start; end - start > 1 && i < end; i++)
+        {
+            DuplicateFile file;
+            file.path = entryPath(table, sized.at(i).second);
+            file.size = sized.at(i).first;
+            file.hash[0] = file.hash[1] = 0;
+            file.device = file.inode = 0;
+            file.readable = true;
+            job->files.push_back(std::move(file));
+        }
+        start = end;
+    }
+    initializeTaskGroup(&job->group);
+    job->stage = DUP_STAGE_LINKS;
+    job->files_done = 0;
+    job->files_total = job->files.size();
+    job->bytes_read = 0;
+    job->bytes_listed = bytes_listed;
+    job->wasted = 0;
+    job->finished = false;
+    job->last_notify = 0;
+    job->event_type = search->event_type;
+    job->generation = search->generation;
+    search->job = job;
+
+    submitTask(pool, &job->group, [job, pool]() {
+        findDuplicates(job, pool);
+    });
+}
+
+void cancelDuplicateSearch(DuplicateSearch *search)
+{
+    //running tasks stop at their next file; nothing more is reported
+    if(search->job)
+    {
+        search->job->group.cancelled = true;
+    }
+    search->job.reset();
+}
+
+bool isCurrentDuplicates(DuplicateSearch *search, SDL_Event *event)
+{
+    return search->job && event->type == search->event_type && event->user.code == search->generation;
+}
+
+bool isDuplicateSearchRunning(DuplicateSearch *search)
+{
+    return search->job && !search->job->finished;
+}
+
+int markDuplicates(DuplicateSearch *search, EntryTable *table)
+{
+    //tags every file of a finished search with its group rank; only entries of a candidate size build their path
+    DuplicateJob *job = search->job.get();
+    std::unordered_map<std::string, uint32_t> ranks;
+    std::unordered_set<uint64_t> sizes;
+    for(int g = 0; g < job->groups.size(); g++)
+    {
+        for(int f = 0; f < job->groups.at(g).size(); f++)
+        {
+            ranks[job->groups.at(g).at(f)] = g + 1;
+        }
+    }
+    for(int i = 0; i < job->files.size(); i++)
+    {
+        sizes.insert(job->files.at(i).size);
+    }
+    for(int i = 0; i < entryCount(table); i++)
+    {
+        table->duplicate_group.at(i) = 0;
+        if(i > 0 && sizes.count(table->size.at(i)) > 0 && !(table->flags.at(i) & ENTRY_DIRECTORY))
+        {
+            std::unordered_map<std::string, uint32_t>::iterator found = ranks.find(entryPath(table, i));
+            if(found != ranks.end())
+            {
+                table->duplicate_group.at(i) = found->second;
+            }
+        }
+    }
+    return job->groups.size();
+}
+
+std::string duplicateStatus(DuplicateSearch *search)
+{
+    if(!search->job)
+    {
+        return "";
+    }
+    DuplicateJob *job = search->job.get();
+    char line[256];
+    if(job->finished) {
+        snprintf(line, sizeof(line), "%d duplicate groups, %s reclaimable, read %s of %s [Ctrl+D leaves]", (int)job->groups.size(),
+                 formatSize(job->wasted).c_str(), formatSize(job->bytes_read).c_str(), formatSize(job->bytes_listed).c_str());
+    } else {
+        snprintf(line, sizeof(line), "Finding duplicates: %s %d/%d files, read %s [Ctrl+D cancels]",
+                 job->stage == DUP_STAGE_LINKS ? "checking links of" : job->stage == DUP_STAGE_EDGES ? "comparing ends of" : "hashing", (int)job->files_done, (int)job->files_total,
+                 formatSize(job->bytes_read).c_str());
+    }
+    return line;
+}
+
+void findDuplicates(std::shared_ptr<DuplicateJob> job, ThreadPool *pool)
+{
+    TRACE_SCOPE("findDuplicates");
+    //hard links are one file: each inode is read once, and a size left with a single inode needs no reading
+    std::vector<int> all(job->files.size());
+    for(int i = 0; i < all.size(); i++)
+    {
+        all.at(i) = i;
+    }
+    hashFiles(job, pool, all, DUP_STAGE_LINKS);
+    std::vector<int> distinct = foldLinks(job.get(), all);
+
+    //stage 1: both ends of every candidate [files up to twice DUP_EDGE_BYTES are read whole here]
+    hashFiles(job, pool, distinct, DUP_STAGE_EDGES);
+    std::vector<std::vector<int> > runs = collidingRuns(job.get(), distinct);
+
+    //stage 2: the whole content, only for larger files whose ends still match
+    std::vector<int> survivors;
+    std::vector<int> larger;
+    for(int r = 0; r < runs.size(); r++)
+    {
+        for(int f = 0; f < runs.at(r).size(); f++)
+        {
+            int i = runs.at(r).at(f);
+            survivors.push_back(i);
+            if(job->files.at(i).size > 2*DUP_EDGE_BYTES)
+            {
+                larger.push_back(i);
+            }
+        }
+    }
+    hashFiles(job, pool, larger, DUP_STAGE_FULL);
+    runs = collidingRuns(job.get(), survivors);
+    if(job->group.cancelled)
+    {
+        return;
+    }
+
+    //the groups wasting the most space come first
+    std::sort(runs.begin(), runs.end(), [&job](const std::vector<int> &first, const std::vector<int> &second) {
+        return job->files.at(first.at(0)).size*(first.size() - 1) > job->files.at(second.at(0)).size*(second.size() - 1);
+    });
+    uint64_t wasted = 0;
+    for(int r = 0; r < runs.size(); r++)
+    {
+        std::vector<std::string> group;
+        for(int f = 0; f < runs.at(r).size(); f++)
+        {
+            DuplicateFile *file = &job->files.at(runs.at(r).at(f));
+            group.push_back(file->path);
+            for(int l = 0; l < file->links.size(); l++)
+            {
+                group.push_back(job->files.at(file->links.at(l)).path);
+            }
+        }
+        job->groups.push_back(group);
+        wasted += job->files.at(runs.at(r).at(0)).size*(runs.at(r).size() - 1);
+    }
+    job->wasted = wasted;
+    job->finished = true;
+    notifyDuplicates(job.get(), true);
+}
+
+void hashFiles(std::shared_ptr<DuplicateJob> job, ThreadPool *pool, const std::vector<int> &files, int stage)
+{
+    //a few dozen files per task; the finder task helps with them while it waits
+    job->stage = stage;
+    job->files_done = 0;
+    job->files_total = files.size();
+    TaskGroup hashing;
+    initializeTaskGroup(&hashing);
+    for(size_t begin = 0; begin < files.size(); begin += DUP_FILES_PER_TASK)
+    {
+        size_t end = std::min(files.size(), begin + DUP_FILES_PER_TASK);
+        submitTask(pool, &hashing, [job, &files, begin, end, stage]() {
+            for(size_t i = begin; i < end && !job->group.cancelled; i++)
+            {
+                DuplicateFile *file = &job->files.at(files.at(i));
+                if(stage == DUP_STAGE_LINKS) {
+                    file->readable = statLinks(file);
+                } else if(stage == DUP_STAGE_EDGES) {
+                    file->readable = hashEdges(job.get(), file);
+                } else {
+                    file->readable = hashWhole(job.get(), file);
+                }
+                job->files_done++;
+                notifyDuplicates(job.get(), false);
+            }
+        });
+    }
+    waitForTasks(pool, &hashing);
+}
+
+bool statLinks(DuplicateFile *file)
+{
+    //the path itself, like the O_NOFOLLOW opens below; a file that changed size since it was listed is left out
+    struct stat info;
+    if(lstat(file->path.c_str(), &info) != 0 || !S_ISREG(info.st_mode) || (uint64_t)info.st_size != file->size)
+    {
+        return false;
+    }
+    file->device = info.st_dev;
+    file->inode = info.st_ino;
+    return true;
+}
+
+std::vector<int> foldLinks(DuplicateJob *job, std::vector<int> candidates)
+{
+    //one candidate per inode stands for its hard links; sizes left with one inode drop out
+    std::vector<DuplicateFile> *files = &job->files;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [files](int i) {
+        return !files->at(i).readable;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [files](int first, int second) {
+        DuplicateFile *a = &files->at(first);
+        DuplicateFile *b = &files->at(second);
+        if(a->device != b->device)
+        {
+            return a->device < b->device;
+        }
+        if(a->inode != b->inode)
+        {
+            return a->inode < b->inode;
+        }
+        return first < second;
+    });
+    std::vector<int> distinct;
+    for(int i = 0; i < candidates.size(); i++)
+    {
+        DuplicateFile *file = &files->at(candidates.at(i));
+        DuplicateFile *kept = distinct.empty() ? NULL : &files->at(distinct.back());
+        if(kept != NULL && kept->device == file->device && kept->inode == file->inode) {
+            kept->links.push_back(candidates.at(i));
+        } else {
+            distinct.push_back(candidates.at(i));
+        }
+    }
+
+    std::sort(distinct.begin(), distinct.end(), [files](int first, int second) {
+        return files->at(first).size != files->at(second).size ? files->at(first).size < files->at(second).size : first < second;
+    });
+    std::vector<int> shared;
+    for(int start = 0; start < distinct.size(); )
+    {
+        int end = start + 1;
+        while(end < distinct.size() && files->at(distinct.at(end)).size == files->at(distinct.at(start)).size)
+        {
+            end++;
+        }
+        if(end - start > 1)
+        {
+            shared.insert(shared.end(), distinct.begin() + start, distinct.begin() + end);
+        }
+        start = end;
+    }
+    return shared;
+}
+
+bool hashEdges(DuplicateJob *job, DuplicateFile *file)
+{
+    int fd = open(file->path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if(fd < 0)
+    {
+        return false;
+    }
+    //head, then the tail that does not overlap it
+    unsigned char buffer[2*DUP_EDGE_BYTES];
+    uint64_t head = std::min<uint64_t>(file->size, DUP_EDGE_BYTES);
+    uint64_t tail_offset = std::max<uint64_t>(head, file->size - std::min<uint64_t>(file->size, DUP_EDGE_BYTES));
+    uint64_t tail = file->size - tail_offset;
+    bool complete = pread(fd, buffer, head, 0) == (ssize_t)head && pread(fd, buffer + head, tail, tail_offset) == (ssize_t)tail;
+    close(fd);
+    if(!complete)
+    {
+        return false;
+    }
+    job->bytes_read += head + tail;
+    ContentHash hash = {0, 0};
+    hashBytes(&hash, buffer, head + tail);
+    finishHash(&hash, file->size, file->hash);
+    return true;
+}
+
+bool hashWhole(DuplicateJob *job, DuplicateFile *file)
+{
+    TRACE_SCOPE("hashWhole");
+    int fd = open(file->path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if(fd < 0)
+    {
+        return false;
+    }
+    //a file that changed size since it was listed is left out
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (uint64_t)info.st_size != file->size)
+    {
+        close(fd);
+        return false;
+    }
+    //read a buffer at a time [a mapping would raise SIGBUS if the file were truncated meanwhile]
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<unsigned char> buffer(std::min<uint64_t>(DUP_READ_BYTES, file->size));
+    ContentHash hash = {0, 0};
+    bool complete = true;
+    for(uint64_t offset = 0; offset < file->size && !job->group.cancelled; offset += buffer.size())
+    {
+        size_t length = std::min<uint64_t>(buffer.size(), file->size - offset);
+        size_t filled = 0;
+        while(filled < length)
+        {
+            ssize_t got = pread(fd, buffer.data() + filled, length - filled, offset + filled);
+            if(got <= 0)
+            {
+                break;
+            }
+            filled += got;
+        }
+        //a file that shrank or failed to read is left out
+        if(filled < length)
+        {
+            complete = false;
+            break;
+        }
+        hashBytes(&hash, buffer.data(), length);
+        job->bytes_read += length;
+    }
+    close(fd);
+    finishHash(&hash, file->size, file->hash);
+    return complete;
+}
+
+std::vector<std::vector<int> > collidingRuns(DuplicateJob *job, std::vector<int> candidates)
+{
+    //readable files with the same size and hash, two or more at a time
+    std::vector<DuplicateFile> *files = &job->files;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [files](int i) {
+        return !files->at(i).readable;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [files](int first, int second) {
+        DuplicateFile *a = &files->at(first);
+        DuplicateFile *b = &files->at(second);
+        if(a->size != b->size)
+        {
+            return a->size < b->size;
+        }
+        if(a->hash[0] != b->hash[0])
+        {
+            return a->hash[0] < b->hash[0];
+        }
+        if(a->hash[1] != b->hash[1])
+        {
+            return a->hash[1] < b->hash[1];
+        }
+        return first < second;
+    });
+    std::vector<std::vector<int> > runs;
+    for(int start = 0; start < candidates.size(); )
+    {
+        DuplicateFile *first = &files->at(candidates.at(start));
+        int end = start + 1;
+        while(end < candidates.size())
+        {
+            DuplicateFile *next = &files->at(candidates.at(end));
+            if(next->size != first->size || next->hash[0] != first->hash[0] || next->hash[1] != first->hash[1])
+            {
+                break;
+            }
+            end++;
+        }
+        if(end - start > 1)
+        {
+            runs.push_back(std::vector<int>(candidates.begin() + start, candidates.begin() + end));
+        }
+        start = end;
+    }
+    return runs;
+}
+
+void notifyDuplicates(DuplicateJob *job, bool force)
+{
+    //at most one wake-up per interval while hashing, and one when done
+    Uint32 now = SDL_GetTicks();
+    Uint32 last = job->last_notify;
+    if(!force && (now - last < DUP_PROGRESS_MS || !job->last_notify.compare_exchange_strong(last, now)))
+    {
+        return;
+    }
+    SDL_Event event;
+    SDL_memset(&event, 0, sizeof(event));
+    event.type = job->event_type;
+    event.user.code = job->generation;
+    SDL_PushEvent(&event);
+}
+
+void hashBytes(ContentHash *hash, const unsigned char *data, size_t length)
+{
+    //only the last call for a file may end in a partial word [DUP_READ_BYTES is a multiple of 8]
+    size_t words = length/8;
+    uint64_t a = hash->a;
+    uint64_t b = hash->b;
+    for(size_t i = 0; i < words; i++)
+    {
+        uint64_t word;
+        memcpy(&word, data + i*8, 8);
+        a = (a ^ word)*0x9E3779B97F4A7C15ULL;
+        a ^= a >> 29;
+        b = (b + word)*0xC2B2AE3D27D4EB4FULL;
+        b = (b << 31) | (b >> 33);
+    }
+    if(length % 8 != 0)
+    {
+        uint64_t word = 0;
+        memcpy(&word, data + words*8, length % 8);
+        a = (a ^ word)*0x9E3779B97F4A7C15ULL;
+        b = (b + word)*0xC2B2AE3D27D4EB4FULL;
+    }
+    hash->a = a;
+    hash->b = b;
+}
+
+void finishHash(ContentHash *hash, uint64_t length, uint64_t *out)
+{
+    uint64_t lanes[2] = {hash->a ^ length, hash->b + length};
+    for(int i = 0; i < 2; i++)
+    {
+        uint64_t x = lanes[i];
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33;
+        out[i] = x;
+    }
+}
@@ -0,0 +1,301 @@
+#include "entries.h"
+#include "sort.h"
+#include <algorithm>
+#include <string.h>
+
+namespace fs = std::filesystem;
+
+uint32_t internDirectory(EntryTable *table, const std::string &dirname);
+void compactNames(EntryTable *table);
+void compactNames(EntryTable *table)
+{
+    //live names are copied in row order and their offsets rewritten
+    std::vector<char> names;
+    names.reserve(table->names.size() - table->dead_names);
+    for(int i = 0; i < entryCount(table); i++)
+    {
+        uint32_t offset = table->name_offset.at(i);
+        table->name_offset.at(i) = names.size();
+        names.insert(names.end(), table->names.begin() + offset, table->names.begin() + offset + table->name_length.at(i));
+    }
+    table->names.swap(names);
+    table->dead_names = 0;
+    table->names_generation++;
+}
+
+template <typename T> void permuteColumn(std::vector<T> *column, const std::vector<int> &order);
+
+void clearEntryTable(EntryTable *table, const std::string &root)
+{
+    table->root = root;
+    table->root_slashes = std::count(root.begin(), root.end(), '/');
+    table->name_offset.clear();
+    table->name_length.clear();
+    table->parent.clear();
+    table->depth.clear();
+    table->size.clear();
+    table->mode.clear();
+    table->mtime.clear();
+    table->icon_type.clear();
+    table->flags.clear();
+    table->duplicate_group.clear();
+    table->names.clear();
+    table->dead_names = 0;
+    table->names_generation++;
+    table->directories.clear();
+    table->directory_depth.clear();
+    table->directory_index.clear();
+}
+
+int entryCount(EntryTable *table)
+{
+    return table->name_offset.size();
+}
+
+void insertEntryRows(EntryTable *table, int position, std::vector<EntryMeta> *entries, std::vector<uint8_t> *icon_types)
+{
+    //new rows are appended, then rotated into place
+    int count = entryCount(table);
+    for(int i = 0; i < entries->size(); i++)
+    {
+        EntryMeta *meta = &(entries->at(i));
+        size_t slash = meta->path.rfind('/');
+        uint32_t parent = internDirectory(table, meta->path.substr(0, slash));
+        size_t length = meta->path.length() - slash - 1;
+
+        table->name_offset.push_back(table->names.size());
+        table->name_length.push_back(length);
+        table->names.insert(table->names.end(), meta->path.begin() + slash + 1, meta->path.end());
+        table->parent.push_back(parent);
+        table->depth.push_back(table->directory_depth.at(parent));
+        table->size.push_back(meta->size);
+        table->mode.push_back(meta->mode);
+        table->mtime.push_back(meta->mtime);
+        table->icon_type.push_back(icon_types->at(i));
+        table->flags.push_back((meta->is_directory ? ENTRY_DIRECTORY : 0) | (meta->is_link ? ENTRY_LINK : 0));
+        table->duplicate_group.push_back(0);
+    }
+    if(position < count)
+    {
+        std::rotate(table->name_offset.begin() + position, table->name_offset.begin() + count, table->name_offset.end());
+        std::rotate(table->name_length.begin() + position, table->name_length.begin() + count, table->name_length.end());
+        std::rotate(table->parent.begin() + position, table->parent.begin() + count, table->parent.end());
+        std::rotate(table->depth.begin() + position, table->depth.begin() + count, table->depth.end());
+        std::rotate(table->size.begin() + position, table->size.begin() + count, table->size.end());
+        std::rotate(table->mode.begin() + position, table->mode.begin() + count, table->mode.end());
+        std::rotate(table->mtime.begin() + position, table->mtime.begin() + count, table->mtime.end());
+        std::rotate(table->icon_type.begin() + position, table->icon_type.begin() + count, table->icon_type.end());
+        std::rotate(table->flags.begin() + position, table->flags.begin() + count, table->flags.end());
+        std::rotate(table->duplicate_group.begin() + position, table->duplicate_group.begin() + count, table->duplicate_group.end());
+    }
+}
+
+void removeEntryRows(EntryTable *table, int position, int count)
+{
+    int end = position + count;
+    for(int i = position; i < end; i++)
+    {
+        table->dead_names += table->name_length.at(i);
+    }
+    table->name_offset.erase(table->name_offset.begin() + position, table->name_offset.begin() + end);
+    table->name_length.erase(table->name_length.begin() + position, table->name_length.begin() + end);
+    table->parent.erase(table->parent.begin() + position, table->parent.begin() + end);
+    table->depth.erase(table->depth.begin() + position, table->depth.begin() + end);
+    table->size.erase(table->size.begin() + position, table->size.begin() + end);
+    table->mode.erase(table->mode.begin() + position, table->mode.begin() + end);
+    table->mtime.erase(table->mtime.begin() + position, table->mtime.begin() + end);
+    table->icon_type.erase(table->icon_type.begin() + position, table->icon_type.begin() + end);
+    table->flags.erase(table->flags.begin() + position, table->flags.begin() + end);
+    table->duplicate_group.erase(table->duplicate_group.begin() + position, table->duplicate_group.begin() + end);
+    if(table->dead_names >= NAMES_COMPACT_MIN && 2*table->dead_names > table->names.size())
+    {
+        compactNames(table);
+    }
+}
+
+void updateEntryRow(EntryTable *table, int position, EntryMeta *meta, uint8_t icon_type)
+{
+    //a changed file may no longer match its duplicates
+    if(table->size.at(position) != meta->size || table->mtime.at(position) != meta->mtime)
+    {
+        table->duplicate_group.at(position) = 0;
+    }
+    table->size.at(position) = meta->size;
+    table->mode.at(position) = meta->mode;
+    table->mtime.at(position) = meta->mtime;
+    table->icon_type.at(position) = icon_type;
+    //a refreshed directory keeps its place in the tree
+    uint8_t tree = table->flags.at(position) & (ENTRY_EXPANDED | ENTRY_COLLAPSED);
+    table->flags.at(position) = (meta->is_directory ? ENTRY_DIRECTORY | tree : 0) | (meta->is_link ? ENTRY_LINK : 0);
+}
+
+void permuteEntryRows(EntryTable *table, const std::vector<int> &order)
+{
+    //row i becomes old row order[i]; names stay where they are in the arena
+    permuteColumn(&table->name_offset, order);
+    permuteColumn(&table->name_length, order);
+    permuteColumn(&table->parent, order);
+    permuteColumn(&table->depth, order);
+    permuteColumn(&table->size, order);
+    permuteColumn(&table->mode, order);
+    permuteColumn(&table->mtime, order);
+    permuteColumn(&table->icon_type, order);
+    permuteColumn(&table->flags, order);
+    permuteColumn(&table->duplicate_group, order);
+}
+
+std::string entryName(EntryTable *table, int i)
+{
+    return std::string(table->names.data() + table->name_offset.at(i), table->name_length.at(i));
+}
+
+std::string entryPath(EntryTable *table, int i)
+{
+    return table->directories.at(table->parent.at(i)) + "/" + entryName(table, i);
+}
+
+int findEntry(EntryTable *table, const std::string &path, bool *found)
+{
+    //binary search in listing order [entry 0 is the parent entry and stays first]
+    int low = 1;
+    int high = entryCount(table);
+    while(low < high)
+    {
+        int middle = low + (high - low)/2;
+        if(comparePreOrder(entryPath(table, middle), path)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *found = (low < entryCount(table) && entryPath(table, low) == path);
+    return low;
+}
+
+int findEntryUnordered(EntryTable *table, const std::string &path, bool *found)
+{
+    //linear search for when the listing is not in path order; compares names in place
+    size_t slash = path.rfind('/');
+    std::unordered_map<std::string, uint32_t>::iterator dir = table->directory_index.find(path.substr(0, slash));
+    *found = false;
+    if(dir == table->directory_index.end())
+    {
+        return entryCount(table);
+    }
+    const char *name = path.data() + slash + 1;
+    size_t length = path.length() - slash - 1;
+    for(int i = 1; i < entryCount(table); i++)
+    {
+        if(table->parent.at(i) == dir->second && table->name_length.at(i) == length &&
+           memcmp(table->names.data() + table->name_offset.at(i), name, length) == 0)
+        {
+            *found = true;
+            return i;
+        }
+    }
+    return entryCount(table);
+}
+
+int subtreeSize(EntryTable *table, int i)
+{
+    //entries below i that are deeper belong to its subtree
+    int count = 0;
+    int end = entryCount(table);
+    while(i + 1 + count < end && table->depth.at(i + 1 + count) > table->depth.at(i))
+    {
+        count++;
+    }
+    return count;
+}
+
+std::string formatSize(uint64_t size)
+{
+    if(size < 1024){
+        return std::to_string(size) + " B";
+    } else if(size < 1048576) {
+        return std::to_string(size/1024) + " KiB";
+    } else if(size < 1073741824) {
+        return std::to_string(size/1048576) + " MiB";
+    } else {
+        return std::to_string(size/1073741824) + " GiB";
+    }
+}
+
+std::string getPermissions(fs::perms p)
+{
+    std::string ret = "";
+
+    //owner
+    if((p & fs::perms::owner_read) != fs::perms::none){
+        ret += "r";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::owner_write) != fs::perms::none){
+        ret += "w";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::owner_exec) != fs::perms::none){
+        ret += "x";
+    } else {
+        ret += "-";
+    }
+    //group
+    if((p & fs::perms::group_read) != fs::perms::none){
+        ret += "r";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::group_write) != fs::perms::none){
+        ret += "w";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::group_exec) != fs::perms::none){
+        ret += "x";
+    } else {
+        ret += "-";
+    }
+    //others
+    if((p & fs::perms::others_read) != fs::perms::none){
+        ret += "r";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::others_write) != fs::perms::none){
+        ret += "w";
+    } else {
+        ret += "-";
+    }
+    if((p & fs::perms::others_exec) != fs::perms::none){
+        ret += "x";
+    } else {
+        ret += "-";
+    }
+    return ret;
+}
+
+uint32_t internDirectory(EntryTable *table, const std::string &dirname)
+{
+    std::unordered_map<std::string, uint32_t>::iterator found = table->directory_index.find(dirname);
+    if(found != table->directory_index.end())
+    {
+        return found->second;
+    }
+    uint32_t id = table->directories.size();
+    table->directories.push_back(dirname);
+    table->directory_depth.push_back(std::count(dirname.begin(), dirname.end(), '/') - table->root_slashes);
+    table->directory_index[dirname] = id;
+    return id;
+}
+
+template <typename T> void permuteColumn(std::vector<T> *column, const std::vector<int> &order)
+{
+    std::vector<T> permuted(order.size());
+    for(int i = 0; i < order.size(); i++)
+    {
+        permuted.at(i) = column->at(order.at(i));
+    }
+    column->swap(permuted);
+}
@@ -0,0 +1,161 @@
+#include "filetype.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//extensions up to 8 characters are packed into one integer, lowercase
+constexpr uint64_t packExtension(const char *extension)
+{
+    uint64_t key = 0;
+    for(int i = 0; extension[i] != '\0'; i++)
+    {
+        char c = extension[i];
+        key = (key << 8) | (uint8_t)((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+    }
+    return key;
+}
+
+typedef struct ExtensionType {
+    const char *extension;
+    int icon;
+} ExtensionType;
+
+//add new extensions here
+constexpr ExtensionType extension_types[] = {
+    {"jpg", ICON_IMAGE}, {"jpeg", ICON_IMAGE}, {"png", ICON_IMAGE}, {"tif", ICON_IMAGE},
+    {"tiff", ICON_IMAGE}, {"gif", ICON_IMAGE}, {"bmp", ICON_IMAGE}, {"webp", ICON_IMAGE},
+    {"mp4", ICON_VIDEO}, {"mov", ICON_VIDEO}, {"mkv", ICON_VIDEO}, {"avi", ICON_VIDEO},
+    {"webm", ICON_VIDEO}, {"m4v", ICON_VIDEO},
+    {"h", ICON_CODE}, {"c", ICON_CODE}, {"cpp", ICON_CODE}, {"py", ICON_CODE},
+    {"java", ICON_CODE}, {"js", ICON_CODE}, {"hpp", ICON_CODE}, {"cc", ICON_CODE},
+    {"cxx", ICON_CODE}, {"hh", ICON_CODE}, {"ts", ICON_CODE}, {"rs", ICON_CODE},
+    {"go", ICON_CODE}, {"sh", ICON_CODE}
+};
+
+//open addressing over a power-of-two table, filled at compile time
+#define EXTENSION_SLOTS 128
+
+constexpr size_t extensionSlot(uint64_t key)
+{
+    return (key*0x9E3779B97F4A7C15ULL) >> (64 - 7);
+}
+
+typedef struct ExtensionTable {
+    uint64_t keys[EXTENSION_SLOTS];
+    uint8_t icons[EXTENSION_SLOTS];
+} ExtensionTable;
+
+constexpr ExtensionTable buildExtensionTable()
+{
+    ExtensionTable table = {};
+    for(const ExtensionType &type : extension_types)
+    {
+        uint64_t key = packExtension(type.extension);
+        size_t slot = extensionSlot(key);
+        while(table.keys[slot] != 0)
+        {
+            slot = (slot + 1) % EXTENSION_SLOTS;
+        }
+        table.keys[slot] = key;
+        table.icons[slot] = type.icon;
+    }
+    return table;
+}
+
+constexpr ExtensionTable extension_table = buildExtensionTable();
+static_assert(sizeof(extension_types)/sizeof(extension_types[0]) < EXTENSION_SLOTS/2, "extension table too full");
+
+int classifyName(const char *name, size_t length)
+{
+    //extension is whatever follows the last dot; a leading dot only marks a hidden file
+    size_t dot = length;
+    size_t start = (length > 8) ? length - 9 : 0;
+    for(size_t i = length; i > start; i--)
+    {
+        if(name[i - 1] == '.')
+        {
+            dot = i - 1;
+            break;
+        }
+    }
+    if(dot == length || dot == 0 || dot + 1 == length)
+    {
+        return ICON_OTHER;
+    }
+
+    uint64_t key = 0;
+    for(size_t i = dot + 1; i < length; i++)
+    {
+        char c = name[i];
+        key = (key << 8) | (uint8_t)((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+    }
+    size_t slot = extensionSlot(key);
+    while(extension_table.keys[slot] != 0)
+    {
+        if(extension_table.keys[slot] == key)
+        {
+            return extension_table.icons[slot];
+        }
+        slot = (slot + 1) % EXTENSION_SLOTS;
+    }
+    return ICON_OTHER;
+}
+
+int classifyEntry(EntryMeta *meta)
+{
+    if(meta->is_directory)
+    {
+        return ICON_DIRECTORY;
+    }
+    if((meta->mode & (S_IXUSR | S_IXGRP | S_IXOTH)) != 0)
+    {
+        return ICON_EXECUTABLE;
+    }
+    size_t slash = meta->path.rfind('/');
+    size_t start = (slash == std::string::npos) ? 0 : slash + 1;
+    return classifyName(meta->path.data() + start, meta->path.length() - start);
+}
+
+int sniffFileType(const std::string &path)
+{
+    //only the first few bytes are read
+    unsigned char head[SNIFF_BYTES];
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+    if(fd < 0)
+    {
+        return ICON_OTHER;
+    }
+    ssize_t length = pread(fd, head, sizeof(head), 0);
+    close(fd);
+    if(length < 4)
+    {
+        return ICON_OTHER;
+    }
+
+    if(memcmp(head, "\x89PNG", 4) == 0 || memcmp(head, "\xFF\xD8\xFF", 3) == 0 ||
+       memcmp(head, "GIF8", 4) == 0 || memcmp(head, "II*\0", 4) == 0 ||
+       memcmp(head, "MM\0*", 4) == 0 || memcmp(head, "BM", 2) == 0 ||
+       (length >= 12 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WEBP", 4) == 0)) {
+        return ICON_IMAGE;
+    } else if((length >= 8 && memcmp(head + 4, "ftyp", 4) == 0) ||
+              memcmp(head, "\x1A\x45\xDF\xA3", 4) == 0 ||
+              (length >= 12 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "AVI ", 4) == 0)) {
+        return ICON_VIDEO;
+    } else if(memcmp(head, "\x7F" "ELF", 4) == 0) {
+        return ICON_EXECUTABLE;
+    } else if(memcmp(head, "#!", 2) == 0) {
+        return ICON_CODE;
+    }
+    return ICON_OTHER;
+}
+
+bool needsSniffing(EntryMeta *meta, int icon_type)
+{
+    //only regular files the name told nothing about are opened
+    const std::string &path = meta->path;
+    size_t slash = path.rfind('/');
+    bool extension = path.find('.', (slash == std::string::npos) ? 1 : slash + 2) != std::string::npos;
+    return icon_type == ICON_OTHER && !extension && S_ISREG(meta->mode);
+}
@@ -0,0 +1,223 @@
+#include "filter.h"
+#include "sort.h"
+#include "trace.h"
+#include <algorithm>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define FOLD_PADDING 16
+
+void foldNames(ListFilter *filter, EntryTable *table);
+void matchEntries(ListFilter *filter, EntryTable *table, const std::vector<int> &candidates, ThreadPool *pool);
+bool findSubstring(const char *text, size_t length, const char *needle, size_t needle_length);
+bool findSubsequence(const char *text, size_t length, const char *needle, size_t needle_length);
+
+void resetFilter(ListFilter *filter)
+{
+    filter->query.clear();
+    filter->fuzzy = false;
+    filter->stale = false;
+    filter->duplicates = false;
+    filter->matches.clear();
+    filter->folded.clear();
+    filter->folded_length = 0;
+    filter->folded_generation = 0;
+}
+
+bool isFiltering(ListFilter *filter)
+{
+    return !filter->query.empty() || filter->duplicates;
+}
+
+void setFilterQuery(ListFilter *filter, EntryTable *table, const std::string &query, bool fuzzy, ThreadPool *pool)
+{
+    TRACE_SCOPE("setFilterQuery");
+    std::string folded(query.length(), '\0');
+    foldCase(query.data(), query.length(), &folded[0]);
+
+    //a longer query can only narrow the previous result, so only those entries are checked
+    bool refine = !filter->stale && fuzzy == filter->fuzzy && !filter->query.empty() &&
+                  folded.compare(0, filter->query.length(), filter->query) == 0;
+    filter->query = folded;
+    filter->fuzzy = fuzzy;
+    if(refine)
+    {
+        std::vector<int> candidates;
+        candidates.swap(filter->matches);
+        matchEntries(filter, table, candidates, pool);
+    }
+    else
+    {
+        refreshFilter(filter, table, pool);
+    }
+}
+
+void refreshFilter(ListFilter *filter, EntryTable *table, ThreadPool *pool)
+{
+    TRACE_SCOPE("refreshFilter");
+    //every entry but the parent entry is a candidate, or every file in a duplicate group, group by group
+    filter->stale = false;
+    filter->matches.clear();
+    if(!isFiltering(filter))
+    {
+        return;
+    }
+    std::vector<int> candidates;
+    if(filter->duplicates) {
+        std::vector<std::pair<uint32_t, int> > grouped;
+        for(int i = 1; i < entryCount(table); i++)
+        {
+            if(table->duplicate_group.at(i) != 0)
+            {
+                grouped.push_back(std::make_pair(table->duplicate_group.at(i), i));
+            }
+        }
+        std::sort(grouped.begin(), grouped.end());
+        for(int i = 0; i < grouped.size(); i++)
+        {
+            candidates.push_back(grouped.at(i).second);
+        }
+    } else {
+        candidates.resize(std::max(0, entryCount(table) - 1));
+        for(int i = 0; i < candidates.size(); i++)
+        {
+            candidates.at(i) = i + 1;
+        }
+    }
+    if(filter->query.empty())
+    {
+        filter->matches.swap(candidates);
+        return;
+    }
+    matchEntries(filter, table, candidates, pool);
+}
+
+bool matchName(const char *name, size_t length, const char *query, size_t query_length, bool fuzzy)
+{
+    //name must be readable 16 bytes past its end [the folded arena is padded for that]
+    if(fuzzy)
+    {
+        return findSubsequence(name, length, query, query_length);
+    }
+    return findSubstring(name, length, query, query_length);
+}
+
+void foldNames(ListFilter *filter, EntryTable *table)
+{
+    //the arena only grows until its names move, so only new names are folded
+    if(table->names_generation != filter->folded_generation || table->names.size() < filter->folded_length)
+    {
+        filter->folded_length = 0;
+        filter->folded_generation = table->names_generation;
+    }
+    filter->folded.resize(table->names.size() + FOLD_PADDING, '\0');
+    foldCase(table->names.data() + filter->folded_length, table->names.size() - filter->folded_length, filter->folded.data() + filter->folded_length);
+    std::fill(filter->folded.end() - FOLD_PADDING, filter->folded.end(), '\0');
+    filter->folded_length = table->names.size();
+}
+
+void matchEntries(ListFilter *filter, EntryTable *table, const std::vector<int> &candidates, ThreadPool *pool)
+{
+    foldNames(filter, table);
+
+    //chunks are matched on the pool and joined in order
+    int chunks = (candidates.size() + FILTER_CHUNK - 1)/FILTER_CHUNK;
+    std::vector<std::vector<int> > results(chunks);
+    const char *names = filter->folded.data();
+    const char *query = filter->query.data();
+    size_t query_length = filter->query.length();
+    bool fuzzy = filter->fuzzy;
+    TaskGroup group;
+    initializeTaskGroup(&group);
+    for(int c = 0; c < chunks; c++)
+    {
+        std::vector<int> *result = &results.at(c);
+        size_t begin = (size_t)c*FILTER_CHUNK;
+        size_t end = std::min(candidates.size(), begin + FILTER_CHUNK);
+        submitTask(pool, &group, [table, &candidates, result, begin, end, names, query, query_length, fuzzy]() {
+            result->reserve(end - begin);
+            for(size_t i = begin; i < end; i++)
+            {
+                int entry = candidates.at(i);
+                const char *name = names + table->name_offset.at(entry);
+                if(matchName(name, table->name_length.at(entry), query, query_length, fuzzy))
+                {
+                    result->push_back(entry);
+                }
+            }
+        });
+    }
+    waitForTasks(pool, &group);
+
+    filter->matches.clear();
+    for(int c = 0; c < chunks; c++)
+    {
+        filter->matches.insert(filter->matches.end(), results.at(c).begin(), results.at(c).end());
+    }
+}
+
+bool findSubstring(const char *text, size_t length, const char *needle, size_t needle_length)
+{
+    if(needle_length == 0)
+    {
+        return true;
+    }
+    if(needle_length > length)
+    {
+        return false;
+    }
+    size_t end = length - needle_length + 1;  //possible start positions
+#ifdef __SSE2__
+    //16 start positions at a time: the first and last needle bytes must both match before comparing the rest
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[needle_length - 1]);
+    for(size_t i = 0; i < end; i += 16)
+    {
+        __m128i head = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(text + i + needle_length - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+        while(mask != 0)
+        {
+            size_t start = i + __builtin_ctz(mask);
+            if(start >= end)
+            {
+                break;
+            }
+            if(needle_length <= 2 || memcmp(text + start + 1, needle + 1, needle_length - 2) == 0)
+            {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return false;
+#else
+    for(size_t i = 0; i < end; i++)
+    {
+        if(text[i] == needle[0] && memcmp(text + i, needle, needle_length) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+
+bool findSubsequence(const char *text, size_t length, const char *needle, size_t needle_length)
+{
+    //each query character is found after the previous one; memchr does the vector work
+    const char *position = text;
+    const char *end = text + length;
+    for(size_t i = 0; i < needle_length; i++)
+    {
+        const char *found = (const char*)memchr(position, needle[i], end - position);
+        if(found == NULL)
+        {
+            return false;
+        }
+        position = found + 1;
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+#include "icons.h"
+#include "trace.h"
+#include <SDL_image.h>
+#include <algorithm>
+#include <stdio.h>
+
+void shrinkIcon(SDL_Surface *icon, Uint32 *cell, int pitch);
+
+//image of each icon type, in icon index order
+static const char *icon_files[ICON_TYPES] = {
+    "resrc/images/directory.png",
+    "resrc/images/executable.png",
+    "resrc/images/image.png",
+    "resrc/images/video.png",
+    "resrc/images/code_file.png",
+    "resrc/images/other.png"
+};
+
+bool initializeIconAtlas(SDL_Renderer *renderer, IconAtlas *atlas)
+{
+    TRACE_SCOPE("initializeIconAtlas");
+    atlas->renderer = renderer;
+    atlas->texture = NULL;
+    int width = ICON_COLUMNS*ICON_CELL;
+    int height = ICON_ROWS*ICON_CELL;
+    std::vector<Uint32> pixels(width*height, 0);
+    for(int i = 0; i < ICON_TYPES; i++)
+    {
+        atlas->source[i] = {(i % ICON_COLUMNS)*ICON_CELL, (i/ICON_COLUMNS)*ICON_CELL, ICON_CELL, ICON_CELL};
+        SDL_Surface *loaded = IMG_Load(icon_files[i]);
+        SDL_Surface *icon = (loaded != NULL) ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0) : NULL;
+        SDL_FreeSurface(loaded);
+        if(icon == NULL)
+        {
+            //the cell stays transparent, the row just has no icon
+            fprintf(stderr, "Error: could not load icon '%s': %s\n", icon_files[i], SDL_GetError());
+            continue;
+        }
+        shrinkIcon(icon, pixels.data() + atlas->source[i].y*width + atlas->source[i].x, width);
+        SDL_FreeSurface(icon);
+    }
+
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+    if(atlas->texture == NULL)
+    {
+        fprintf(stderr, "Error: could not create icon atlas: %s\n", SDL_GetError());
+        return false;
+    }
+    countTexture(width, height, 1);
+    SDL_UpdateTexture(atlas->texture, NULL, pixels.data(), width*sizeof(Uint32));
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void cleanIconAtlas(IconAtlas *atlas)
+{
+    if(atlas->texture != NULL)
+    {
+        countTexture(ICON_COLUMNS*ICON_CELL, ICON_ROWS*ICON_CELL, -1);
+    }
+    SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+    atlas->vertices.clear();
+    atlas->indices.clear();
+}
+
+void queueIcon(IconAtlas *atlas, int type, const SDL_Rect *dest)
+{
+    //two triangles per icon
+    SDL_Rect *source = &atlas->source[type];
+    float width = ICON_COLUMNS*ICON_CELL;
+    float height = ICON_ROWS*ICON_CELL;
+    float left = dest->x;
+    float top = dest->y;
+    float right = dest->x + dest->w;
+    float bottom = dest->y + dest->h;
+    float u0 = source->x/width;
+    float v0 = source->y/height;
+    float u1 = (source->x + source->w)/width;
+    float v1 = (source->y + source->h)/height;
+    SDL_Color white = { 255, 255, 255, 255 };
+
+    int base = atlas->vertices.size();
+    atlas->vertices.push_back({{left, top}, white, {u0, v0}});
+    atlas->vertices.push_back({{right, top}, white, {u1, v0}});
+    atlas->vertices.push_back({{right, bottom}, white, {u1, v1}});
+    atlas->vertices.push_back({{left, bottom}, white, {u0, v1}});
+    int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    atlas->indices.insert(atlas->indices.end(), quad, quad + 6);
+}
+
+void flushIcons(IconAtlas *atlas)
+{
+    TRACE_SCOPE("flushIcons");
+    if(!atlas->indices.empty() && atlas->texture != NULL)
+    {
+        SDL_RenderGeometry(atlas->renderer, atlas->texture, atlas->vertices.data(), atlas->vertices.size(),
+                           atlas->indices.data(), atlas->indices.size());
+    }
+    atlas->vertices.clear();
+    atlas->indices.clear();
+}
+
+void shrinkIcon(SDL_Surface *icon, Uint32 *cell, int pitch)
+{
+    //each cell pixel averages the block of source pixels it covers, weighting colour by alpha so
+    //transparent edges do not darken [a plain scaled blit would just pick one pixel per block]
+    SDL_LockSurface(icon);
+    for(int y = 0; y < ICON_CELL; y++)
+    {
+        int y0 = y*icon->h/ICON_CELL;
+        int y1 = std::max(y0 + 1, (y + 1)*icon->h/ICON_CELL);
+        for(int x = 0; x < ICON_CELL; x++)
+        {
+            int x0 = x*icon->w/ICON_CELL;
+            int x1 = std::max(x0 + 1, (x + 1)*icon->w/ICON_CELL);
+            uint64_t a = 0, r = 0, g = 0, b = 0;
+            for(int sy = y0; sy < y1; sy++)
+            {
+                const Uint32 *row = (const Uint32 *)((const Uint8 *)icon->pixels + sy*icon->pitch);
+                for(int sx = x0; sx < x1; sx++)
+                {
+                    Uint32 p = row[sx];
+                    Uint32 alpha = p >> 24;
+                    a += alpha;
+                    r += ((p >> 16) & 0xFF)*alpha;
+                    g += ((p >> 8) & 0xFF)*alpha;
+                    b += (p & 0xFF)*alpha;
+                }
+            }
+            int count = (y1 - y0)*(x1 - x0);
+            Uint32 pixel = 0;
+            if(a > 0)
+            {
+                pixel = (Uint32)(a/count) << 24 | (Uint32)(r/a) << 16 | (Uint32)(g/a) << 8 | (Uint32)(b/a);
+            }
+            cell[y*pitch + x] = pixel;
+        }
+    }
+    SDL_UnlockSurface(icon);
+}
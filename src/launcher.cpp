@@ -0,0 +1,246 @@
+#include "launcher.h"
+#include "trace.h"
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+extern char **environ;
+
+void readChildSignals(Launcher *launcher);
+void collectChildren(Launcher *launcher);
+void spawnQueued(Launcher *launcher);
+std::string resolveHandler(Launcher *launcher, int icon_type);
+
+void blockChildSignal()
+{
+    //must run before any thread starts so every thread inherits the mask and only the signalfd sees SIGCHLD
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+}
+
+bool startLauncher(Launcher *launcher, Uint32 event_type)
+{
+    launcher->event_type = event_type;
+    launcher->notified = false;
+    for(int i = 0; i < ICON_TYPES; i++)
+    {
+        launcher->resolved[i] = false;
+    }
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    launcher->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    launcher->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if(launcher->signal_fd < 0 || launcher->stop_fd < 0)
+    {
+        //files still open; finished children are then only reaped on the next launch
+        fprintf(stderr, "Error: could not start child reaper: %s\n", strerror(errno));
+        return false;
+    }
+    launcher->reaper = std::thread(readChildSignals, launcher);
+    return true;
+}
+
+void stopLauncher(Launcher *launcher)
+{
+    if(launcher->reaper.joinable())
+    {
+        uint64_t one = 1;
+        write(launcher->stop_fd, &one, sizeof(one));
+        launcher->reaper.join();
+    }
+    if(launcher->signal_fd >= 0)
+    {
+        close(launcher->signal_fd);
+    }
+    if(launcher->stop_fd >= 0)
+    {
+        close(launcher->stop_fd);
+    }
+    launcher->signal_fd = -1;
+    launcher->stop_fd = -1;
+    //handlers still running outlive the explorer [they run in their own session]
+    launcher->queued.clear();
+}
+
+void launchFile(Launcher *launcher, const std::string &path, int icon_type)
+{
+    TRACE_SCOPE("launchFile");
+    collectChildren(launcher);
+    LaunchRequest request = {path, icon_type};
+    launcher->queued.push_back(request);
+    spawnQueued(launcher);
+}
+
+bool reapChildren(Launcher *launcher, SDL_Event *event)
+{
+    //a handler exited: collect it and start the next queued ones
+    if(event->type != launcher->event_type)
+    {
+        return false;
+    }
+    launcher->notified = false;
+    collectChildren(launcher);
+    spawnQueued(launcher);
+    return true;
+}
+
+void collectChildren(Launcher *launcher)
+{
+    int status;
+    pid_t pid;
+    while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        std::unordered_map<pid_t, std::string>::iterator child = launcher->running.find(pid);
+        if(child == launcher->running.end())
+        {
+            continue;
+        }
+        if(WIFEXITED(status) && WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "Error: could not open %s (handler exited with %d)\n", child->second.c_str(), WEXITSTATUS(status));
+        }
+        else if(WIFSIGNALED(status))
+        {
+            fprintf(stderr, "Error: could not open %s (handler killed by signal %d)\n", child->second.c_str(), WTERMSIG(status));
+        }
+        launcher->running.erase(child);
+    }
+}
+
+void spawnQueued(Launcher *launcher)
+{
+    //the child starts with the default signal mask and dispositions, in its own session, reading /dev/null
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty;
+    sigset_t defaults;
+    sigemptyset(&empty);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+#ifdef POSIX_SPAWN_SETSID
+    flags |= POSIX_SPAWN_SETSID;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+
+    while(launcher->running.size() < LAUNCH_BATCH && !launcher->queued.empty())
+    {
+        LaunchRequest request = launcher->queued.front();
+        launcher->queued.pop_front();
+        std::string handler = resolveHandler(launcher, request.icon_type);
+        if(handler.empty())
+        {
+            continue;
+        }
+        char *argv[3] = {(char*)handler.c_str(), (char*)request.path.c_str(), NULL};
+        pid_t pid;
+        int error = posix_spawnp(&pid, handler.c_str(), &actions, &attr, argv, environ);
+        if(error != 0)
+        {
+            fprintf(stderr, "Error: could not start %s for %s: %s\n", handler.c_str(), request.path.c_str(), strerror(error));
+            continue;
+        }
+        launcher->running[pid] = request.path;
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+}
+
+std::string resolveHandler(Launcher *launcher, int icon_type)
+{
+    //searched on PATH the first time a type is opened; later launches skip the search
+    if(icon_type < 0 || icon_type >= ICON_TYPES)
+    {
+        icon_type = ICON_OTHER;
+    }
+    if(launcher->resolved[icon_type])
+    {
+        return launcher->handlers[icon_type];
+    }
+    const char *programs[ICON_TYPES] = LAUNCH_HANDLERS;
+    const char *program = programs[icon_type];
+    launcher->resolved[icon_type] = true;
+    if(program == NULL)
+    {
+        return "";
+    }
+
+    std::string found;
+    const char *path_env = getenv("PATH");
+    std::string search = (path_env != NULL) ? path_env : "/usr/local/bin:/usr/bin:/bin";
+    size_t start = 0;
+    while(found.empty() && start <= search.length())
+    {
+        size_t end = search.find(':', start);
+        if(end == std::string::npos)
+        {
+            end = search.length();
+        }
+        std::string dir = (end > start) ? search.substr(start, end - start) : ".";
+        std::string candidate = dir + "/" + program;
+        if(access(candidate.c_str(), X_OK) == 0)
+        {
+            found = candidate;
+        }
+        start = end + 1;
+    }
+    if(found.empty())
+    {
+        fprintf(stderr, "Error: %s was not found on PATH, files of this type cannot be opened\n", program);
+    }
+    launcher->handlers[icon_type] = found;
+    return found;
+}
+
+void readChildSignals(Launcher *launcher)
+{
+    traceThreadName("reaper");
+    struct signalfd_siginfo info[16];
+    while(true)
+    {
+        struct pollfd fds[2] = {{launcher->signal_fd, POLLIN, 0}, {launcher->stop_fd, POLLIN, 0}};
+        int ready = poll(fds, 2, -1);
+        if(ready < 0 && errno != EINTR)
+        {
+            return;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            return;
+        }
+        if(fds[0].revents & POLLIN)
+        {
+            //SIGCHLD coalesces, so one wakeup can stand for several children; the loop reaps them all
+            while(read(launcher->signal_fd, info, sizeof(info)) > 0)
+            {
+            }
+            if(!launcher->notified.exchange(true))
+            {
+                SDL_Event event;
+                SDL_memset(&event, 0, sizeof(event));
+                event.type = launcher->event_type;
+                SDL_PushEvent(&event);
+            }
+        }
+    }
+}
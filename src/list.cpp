@@ -0,0 +1,145 @@
+#include "list.h"
+#include "walk.h"
+#include "entries.h"
+#include "filetype.h"
+#include "trace.h"
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace fs = std::filesystem;
+
+void appendEntry(std::string *out, EntryMeta *meta, size_t prefix, int format, bool first);
+void appendEscaped(std::string *out, const char *text, size_t length, int format);
+
+//type column, by icon index
+static const char *type_names[] = {"directory", "executable", "image", "video", "code", "other"};
+
+int parseListFormat(const char *name)
+{
+    if(strcmp(name, "tsv") == 0) {
+        return LIST_TSV;
+    } else if(strcmp(name, "json") == 0) {
+        return LIST_JSON;
+    } else if(strcmp(name, "ndjson") == 0) {
+        return LIST_NDJSON;
+    }
+    return -1;
+}
+
+int listDirectory(const std::string &dirname, int max_depth, int format, ThreadPool *pool)
+{
+    TRACE_SCOPE("listDirectory");
+    struct stat info;
+    if(stat(dirname.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+    {
+        fprintf(stderr, "Error: '%s' is not a readable directory\n", dirname.c_str());
+        return 1;
+    }
+    //the walker joins names with '/', so a trailing one would double up
+    std::string root = dirname;
+    while(root.length() > 1 && root.back() == '/')
+    {
+        root.pop_back();
+    }
+    size_t prefix = (root == "/") ? 2 : root.length() + 1;
+
+    static char buffer[LIST_BUFFER_SIZE];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    if(format == LIST_JSON)
+    {
+        fputs("[", stdout);
+    }
+
+    //batches arrive in listing order and one at a time [the walker holds its lock while emitting];
+    //a slow reader stops the walker's scan-ahead at WALK_MAX_BUFFERED entries, so memory stays bounded
+    bool first = true;
+    std::string out;
+    std::shared_ptr<WalkJob> job = startWalk(root, max_depth, pool, NULL, [&first, &out, prefix, format](std::vector<EntryMeta> *batch, bool) {
+        out.clear();
+        for(int i = 0; i < batch->size(); i++)
+        {
+            appendEntry(&out, &(batch->at(i)), prefix, format, first);
+            first = false;
+        }
+        fwrite(out.data(), 1, out.length(), stdout);
+    });
+    waitForTasks(pool, &job->group);
+
+    if(format == LIST_JSON)
+    {
+        fputs(first ? "]\n" : "\n]\n", stdout);
+    }
+    fflush(stdout);
+    if(ferror(stdout))
+    {
+        fprintf(stderr, "Error: could not write the listing: %s\n", strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+void appendEntry(std::string *out, EntryMeta *meta, size_t prefix, int format, bool first)
+{
+    const char *name = meta->path.data() + prefix;
+    size_t length = meta->path.length() - prefix;
+    const char *type = type_names[classifyEntry(meta)];
+    std::string size = std::to_string(meta->size);
+    std::string permissions = getPermissions(fs::perms(meta->mode & 0777));
+
+    if(format == LIST_TSV)
+    {
+        appendEscaped(out, name, length, format);
+        out->append("\t").append(type).append("\t").append(size).append("\t").append(permissions).append("\n");
+        return;
+    }
+    if(format == LIST_JSON)
+    {
+        out->append(first ? "\n" : ",\n");
+    }
+    out->append("{\"name\":\"");
+    appendEscaped(out, name, length, format);
+    out->append("\",\"type\":\"").append(type).append("\",\"size\":").append(size);
+    out->append(",\"permissions\":\"").append(permissions).append("\"}");
+    if(format == LIST_NDJSON)
+    {
+        out->append("\n");
+    }
+}
+
+void appendEscaped(std::string *out, const char *text, size_t length, int format)
+{
+    //names may hold any byte but '/' and NUL; TSV escapes its separators, JSON its specials and control characters
+    //[bytes that are not valid UTF-8 are passed through as they are]
+    size_t start = 0;
+    for(size_t i = 0; i < length; i++)
+    {
+        unsigned char c = text[i];
+        bool special = (c == '\\' || c < 0x20 || (c == '"' && format != LIST_TSV));
+        if(!special)
+        {
+            continue;
+        }
+        out->append(text + start, i - start);
+        start = i + 1;
+        if(c == '\\') {
+            out->append("\\\\");
+        } else if(c == '"') {
+            out->append("\\\"");
+        } else if(c == '\t') {
+            out->append("\\t");
+        } else if(c == '\n') {
+            out->append("\\n");
+        } else if(c == '\r') {
+            out->append("\\r");
+        } else if(format == LIST_TSV) {
+            out->push_back(c);
+        } else {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out->append(escape);
+        }
+    }
+    out->append(text + start, length - start);
+}
@@ -0,0 +1,174 @@
+#include "loader.h"
+#include "filetype.h"
+
+void startDirectoryScan(DirectoryScan *scan, const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, Uint32 event_type)
+{
+    cancelDirectoryScan(scan);
+    scan->generation++;
+
+    std::shared_ptr<ScanResults> results = std::make_shared<ScanResults>();
+    results->finished = false;
+    results->notified = false;
+    results->event_type = event_type;
+    results->generation = scan->generation;
+    scan->results = results;
+
+    //runs on a pool worker for every run of entries the walk produces
+    scan->job = startWalk(dirname, max_depth, pool, cache, [results](std::vector<EntryMeta> *batch, bool finished) {
+        std::lock_guard<std::mutex> guard(results->lock);
+        results->entries.insert(results->entries.end(), std::make_move_iterator(batch->begin()), std::make_move_iterator(batch->end()));
+        results->finished = finished;
+        if(!results->notified)
+        {
+            SDL_Event event;
+            SDL_memset(&event, 0, sizeof(event));
+            event.type = results->event_type;
+            event.user.code = results->generation;
+            SDL_PushEvent(&event);
+            results->notified = true;
+        }
+    });
+}
+
+void cancelDirectoryScan(DirectoryScan *scan)
+{
+    //the walk's tasks still own the job and free it once they drain
+    if(scan->job)
+    {
+        cancelWalk(scan->job.get());
+    }
+    scan->job.reset();
+    scan->results.reset();
+}
+
+bool isCurrentScan(DirectoryScan *scan, SDL_Event *event)
+{
+    return scan->results && event->type == scan->results->event_type && event->user.code == scan->generation;
+}
+
+bool takeScanResults(DirectoryScan *scan, std::vector<EntryMeta> *entries)
+{
+    std::lock_guard<std::mutex> guard(scan->results->lock);
+    entries->swap(scan->results->entries);
+    scan->results->entries.clear();
+    scan->results->notified = false;
+    return scan->results->finished;
+}
+
+void startDirectorySizes(DirectorySizes *sizes, const std::vector<std::string> &directories, ThreadPool *pool, UsageCache *cache, Uint32 event_type)
+{
+    //the previous job keeps its totals readable until this one replaces it
+    if(sizes->job)
+    {
+        cancelUsage(sizes->job.get());
+    }
+    sizes->generation++;
+
+    std::shared_ptr<SizeUpdates> updates = std::make_shared<SizeUpdates>();
+    updates->notified = false;
+    updates->event_type = event_type;
+    updates->generation = sizes->generation;
+    sizes->updates = updates;
+
+    sizes->job = startUsage(directories, pool, cache, [updates](bool) {
+        if(!updates->notified.exchange(true))
+        {
+            SDL_Event event;
+            SDL_memset(&event, 0, sizeof(event));
+            event.type = updates->event_type;
+            event.user.code = updates->generation;
+            SDL_PushEvent(&event);
+        }
+    });
+}
+
+void cancelDirectorySizes(DirectorySizes *sizes)
+{
+    if(sizes->job)
+    {
+        cancelUsage(sizes->job.get());
+    }
+    sizes->job.reset();
+    sizes->updates.reset();
+}
+
+bool isCurrentSizes(DirectorySizes *sizes, SDL_Event *event)
+{
+    return sizes->updates && event->type == sizes->updates->event_type && event->user.code == sizes->generation;
+}
+
+bool takeSizeUpdate(DirectorySizes *sizes)
+{
+    //later progress pushes a new event
+    sizes->updates->notified = false;
+    return isUsageFinished(sizes->job.get());
+}
+
+void queueSniffing(TypeSniffing *sniffing, std::vector<std::string> paths, ThreadPool *pool)
+{
+    //batches of one listing share a generation; cancelling starts a new one
+    if(!sniffing->results)
+    {
+        std::shared_ptr<SniffResults> results = std::make_shared<SniffResults>();
+        initializeTaskGroup(&results->group);
+        results->notified = false;
+        results->event_type = sniffing->event_type;
+        results->generation = ++sniffing->generation;
+        sniffing->results = results;
+    }
+    std::shared_ptr<SniffResults> results = sniffing->results;
+    std::shared_ptr<std::vector<std::string> > shared = std::make_shared<std::vector<std::string> >(std::move(paths));
+    for(size_t begin = 0; begin < shared->size(); begin += SNIFF_BATCH)
+    {
+        size_t end = std::min(shared->size(), begin + SNIFF_BATCH);
+        submitTask(pool, &results->group, [results, shared, begin, end]() {
+            std::vector<std::pair<std::string, uint8_t> > types;
+            for(size_t i = begin; i < end && !results->group.cancelled; i++)
+            {
+                int type = sniffFileType(shared->at(i));
+                if(type != ICON_OTHER)
+                {
+                    types.push_back(std::make_pair(shared->at(i), (uint8_t)type));
+                }
+            }
+            std::lock_guard<std::mutex> guard(results->lock);
+            if(types.empty() || results->group.cancelled)
+            {
+                return;
+            }
+            results->types.insert(results->types.end(), types.begin(), types.end());
+            if(!results->notified)
+            {
+                SDL_Event event;
+                SDL_memset(&event, 0, sizeof(event));
+                event.type = results->event_type;
+                event.user.code = results->generation;
+                SDL_PushEvent(&event);
+                results->notified = true;
+            }
+        });
+    }
+}
+
+void cancelSniffing(TypeSniffing *sniffing)
+{
+    //queued batches are skipped; the tasks still own the results and free them once they drain
+    if(sniffing->results)
+    {
+        sniffing->results->group.cancelled = true;
+    }
+    sniffing->results.reset();
+}
+
+bool isCurrentSniffing(TypeSniffing *sniffing, SDL_Event *event)
+{
+    return sniffing->results && event->type == sniffing->event_type && event->user.code == sniffing->generation;
+}
+
+void takeSniffedTypes(TypeSniffing *sniffing, std::vector<std::pair<std::string, uint8_t> > *types)
+{
+    std::lock_guard<std::mutex> guard(sniffing->results->lock);
+    types->swap(sniffing->results->types);
+    sniffing->results->types.clear();
+    sniffing->results->notified = false;
+}
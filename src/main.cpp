@@ -5,11 +5,14 @@
 #include <string>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <unistd.h>
+#include "app.h"
+#include "list.h"
 
 
 /*
@@ -18,157 +21,479 @@
         no changes were made.
 */
 
-#define WIDTH 800
-#define HEIGHT 600
-
 using namespace std;
-namespace fs = std::filesystem;
-
-typedef struct AppData {
-    TTF_Font *font;
-    //file name
-    std::vector<std::string> name;
-    std::vector<SDL_Texture*> name_text;
-    std::vector<SDL_Rect> name_coordinates;
-    //file icon
-    std::vector<SDL_Texture*> icon;
-    std::vector<SDL_Rect> icon_coordinates;
-    std::vector<int> icon_type;
-    //file permissions
-    std::vector<std::string> permissions;
-    std::vector<SDL_Texture*> permissions_text;
-    std::vector<SDL_Rect> permissions_coordinates;
-    //file size
-    std::vector<std::string> size;
-    std::vector<SDL_Texture*> size_text;
-    std::vector<SDL_Rect> size_coordinates;
-
-    //header
-    SDL_Rect header_box;
-    SDL_Texture *name_header;
-    SDL_Rect name_header_coordinates;
-    SDL_Texture *size_header;
-    SDL_Rect size_header_coordinates;
-    SDL_Texture *permissions_header;
-    SDL_Rect permissions_header_coordinates;
-    //button
-    SDL_Texture *button_text;
-    SDL_Rect button_text_coordinates;
-    SDL_Rect recursive_button_outline;
-    SDL_Rect recursive_button;
-    bool recursive_viewing_mode;
-
-    //scrollbar
-    SDL_Rect scrollbar_outline;
-    SDL_Rect scrollbar;
-    SDL_Point scrollbar_offset;
-    bool scrollbar_selected;
-
-    //general y offset vector
-    std::vector<SDL_Point> y_origin;
-
-    //current directory
-    std::string directory;
-
-} AppData;
-
-void initialize(SDL_Renderer *renderer, AppData *data_ptr);
-void initializeIcons(SDL_Renderer *renderer, AppData *data_ptr);
-void render(SDL_Renderer *renderer, AppData *data_ptr);
-void getFileData(std::string dirname, AppData *data_ptr);
-std::vector<std::string> listDirectory(std::string dirname, bool recurse);
-bool compareNoCase (std::string first, std::string second);
-void cleanTextures(AppData *data_ptr);
-void cleanIcons(AppData *data_ptr);
-std::string getPermissions(fs::perms p);
-int slashCount(std::string path);
 
 int main(int argc, char **argv)
 {
+    //optional limit on how many levels "All Files" descends, listing cache size, content sniffing,
+    //a persistent index of the home tree, image thumbnails, and a headless listing or index search instead of the window
+    int depth_limit = WALK_UNLIMITED;
+    size_t cache_budget = CACHE_DEFAULT_BUDGET;
+    bool sniff_types = false;
+    bool thumbnails = false;
+    size_t thumb_budget = THUMB_DEFAULT_BUDGET;
+    std::string thumb_dir;
+    std::string index_file;
+    std::string list_dir;
+    bool list_recursive = false;
+    int list_format = LIST_TSV;
+    std::string search_query;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+        {
+            depth_limit = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc)
+        {
+            cache_budget = (size_t)atoi(argv[++i])*1024*1024;
+        }
+        else if(strcmp(argv[i], "--sniff") == 0)
+        {
+            sniff_types = true;
+        }
+        else if(strcmp(argv[i], "--thumbnails") == 0)
+        {
+            thumbnails = true;
+        }
+        else if(strcmp(argv[i], "--thumb-mb") == 0 && i + 1 < argc)
+        {
+            thumb_budget = (size_t)atoi(argv[++i])*1024*1024;
+        }
+        else if(strcmp(argv[i], "--thumb-cache") == 0)
+        {
+            thumb_dir = defaultThumbnailDir();
+        }
+        else if(strcmp(argv[i], "--thumb-dir") == 0 && i + 1 < argc)
+        {
+            thumb_dir = argv[++i];
+        }
+        else if(strcmp(argv[i], "--index") == 0)
+        {
+            index_file = defaultIndexFile();
+        }
+        else if(strcmp(argv[i], "--index-file") == 0 && i + 1 < argc)
+        {
+            index_file = argv[++i];
+        }
+        else if(strcmp(argv[i], "--list") == 0 && i + 1 < argc)
+        {
+            list_dir = argv[++i];
+        }
+        else if(strcmp(argv[i], "--search") == 0 && i + 1 < argc)
+        {
+            search_query = argv[++i];
+        }
+        else if(strcmp(argv[i], "--recursive") == 0)
+        {
+            list_recursive = true;
+        }
+        else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            list_format = parseListFormat(argv[++i]);
+            if(list_format < 0)
+            {
+                fprintf(stderr, "Error: unknown format '%s' [tsv, json or ndjson]\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    //--list writes the listing to stdout and exits without touching SDL, so it runs without a display
+    if(!list_dir.empty())
+    {
+        ThreadPool *pool = createThreadPool(0);
+        int status = listDirectory(list_dir, list_recursive ? depth_limit : 0, list_format, pool);
+        destroyThreadPool(pool);
+        return status;
+    }
+
+    //--search prints the indexed paths whose name contains the query, as fast as the index can be mapped
+    if(!search_query.empty())
+    {
+        std::string filename = index_file.empty() ? defaultIndexFile() : index_file;
+        std::shared_ptr<TreeIndex> index = openTreeIndex(filename);
+        if(!index)
+        {
+            fprintf(stderr, "Error: no index at '%s' [run the explorer with --index once to build it]\n", filename.c_str());
+            return 1;
+        }
+        ThreadPool *pool = createThreadPool(0);
+        std::vector<std::string> paths = searchTreeIndex(index.get(), search_query, false, 0, pool);
+        destroyThreadPool(pool);
+        for(int i = 0; i < paths.size(); i++)
+        {
+            fwrite(paths.at(i).data(), 1, paths.at(i).length(), stdout);
+            fputc('\n', stdout);
+        }
+        return 0;
+    }
+
     std::string home = getenv("HOME");
     std::cout << "HOME: " << home << std::endl;
 
+    //FILEEXPLORER_TRACE=file records from launch and writes the trace on exit
+    const char *trace_env = getenv(TRACE_ENV);
+    std::string trace_file = (trace_env != NULL && trace_env[0] != '\0') ? trace_env : TRACE_DEFAULT_FILE;
+    traceThreadName("main");
+    if(trace_env != NULL && trace_env[0] != '\0')
+    {
+        startTrace();
+    }
+
+    //SIGCHLD goes to the launcher's signalfd only, so it is blocked before SDL or the pool start threads
+    blockChildSignal();
+
     // initializing SDL as Video
     SDL_Init(SDL_INIT_VIDEO);
     IMG_Init(IMG_INIT_PNG);
     TTF_Init();
 
-    // create window and renderer
-    SDL_Renderer *renderer;
-    SDL_Window *window;
-    SDL_CreateWindowAndRenderer(WIDTH, HEIGHT, 0, &window, &renderer);
+    // create window and renderer [presents wait for vsync where the driver supports it]
+    SDL_Window *window = SDL_CreateWindow("", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WIDTH, HEIGHT, 0);
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+    if(renderer == NULL)
+    {
+        renderer = SDL_CreateRenderer(window, -1, 0);
+    }
+
+    // load font and glyph atlas once; every string is drawn from the atlas
+    AppData data;
+    data.font = TTF_OpenFont("resrc/OpenSans-Regular.ttf", 18);
+    initializeGlyphAtlas(renderer, data.font, &data.text);
 
     // initialize
-    AppData data;
     data.recursive_viewing_mode = false;
-    data.directory = home;
+    data.scroll_offset = 0;
+    data.scroll_velocity = 0;
+    data.scroll_fraction = 0;
+    data.recursive_depth = depth_limit;
+    data.sniff_types = sniff_types;
+    data.sniffing.event_type = SDL_RegisterEvents(1);
+    data.sniffing.generation = 0;
+    data.thumbnails = thumbnails;
+    if(thumbnails)
+    {
+        initializeThumbnails(&data.thumbs, thumb_budget, thumb_dir, SDL_RegisterEvents(1));
+    }
+    data.sort_order = {SORT_NAME, false};
+    data.filter_focused = false;
+    resetFilter(&data.filter);
+    data.entries.names_generation = 0;
+    data.pool = createThreadPool(0);
+    data.background = createThreadPool(BACKGROUND_THREADS);
+    initializeDirectoryCache(&data.cache, cache_budget);
+    data.index_refresh.running = false;
+    initializeTaskGroup(&data.index_refresh.group);
+    if(!index_file.empty())
+    {
+        //the last index is usable right away; a fresh one replaces it once the tree has been revalidated
+        setCacheTree(&data.cache, openTreeIndex(index_file));
+        startIndexRefresh(&data.index_refresh, normalizeDirectory(home), index_file, data.background, &data.cache);
+    }
+    data.scan.generation = 0;
+    data.scan_event = SDL_RegisterEvents(1);
+    startWatch(&data.watch, SDL_RegisterEvents(1));
+    startLauncher(&data.launcher, SDL_RegisterEvents(1));
+    initializeTransfers(&data.transfers, SDL_RegisterEvents(1));
+    data.clipboard_operation = TRANSFER_COPY;
+    data.delete_armed = false;
+    data.duplicates.event_type = SDL_RegisterEvents(1);
+    data.duplicates.generation = 0;
+    initializeUsageCache(&data.usage_cache);
+    data.sizes.generation = 0;
+    data.sizes_event = SDL_RegisterEvents(1);
+    data.expand_event = SDL_RegisterEvents(1);
+    data.expand_generation = 0;
+    data.hud_visible = false;
+    data.frame_ms = 0;
+    data.directory = normalizeDirectory(home);
     initialize(renderer, &data);
     initializeIcons(renderer, &data);
 
-    //scrollbar vars
-    bool moving = false;
-    int motion_root = 0;
-
-    //render
-    render(renderer, &data);
+    //frames are drawn only when something visible changed, at most once per display refresh
+    SDL_RendererInfo renderer_info;
+    SDL_GetRendererInfo(renderer, &renderer_info);
+    bool vsync = (renderer_info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+    SDL_DisplayMode display_mode;
+    int refresh_rate = (SDL_GetCurrentDisplayMode(0, &display_mode) == 0 && display_mode.refresh_rate > 0) ? display_mode.refresh_rate : 60;
+    Uint32 frame_interval = 1000/refresh_rate;
+    Uint32 last_frame = 0;
+    bool dirty = true;
 
     //run rendering loop
     SDL_Event event;
-    SDL_WaitEvent(&event);
-    while (event.type != SDL_QUIT)
+    while (true)
     {
-        //render(renderer);
-        SDL_WaitEvent(&event);
+        //every pending event is handled before the next frame, so a burst of motion or scan updates costs one redraw
+        if(!SDL_PollEvent(&event))
+        {
+            //a fling in progress moves the view every frame
+            if(stepScroll(&data))
+            {
+                dirty = true;
+            }
+            Uint32 since_frame = SDL_GetTicks() - last_frame;
+            if(dirty && (vsync || since_frame >= frame_interval))
+            {
+                //filtered rows follow every change to the listing
+                if(data.filter.stale && isFiltering(&data.filter))
+                {
+                    refreshFilter(&data.filter, &data.entries, data.pool);
+                    updateScrollbar(&data);
+                }
+                render(renderer, &data);
+                last_frame = SDL_GetTicks();
+                dirty = false;
+            }
+            else if(dirty)
+            {
+                //without vsync the frame waits for its slot, still taking events meanwhile
+                SDL_WaitEventTimeout(NULL, frame_interval - since_frame);
+            }
+            else
+            {
+                //idle until something happens
+                SDL_WaitEvent(NULL);
+            }
+            continue;
+        }
+        if(event.type == SDL_QUIT)
+        {
+            break;
+        }
+        TRACE_SCOPE("event");
+
+        //entries streamed in from the background scan
+        if(isCurrentScan(&data.scan, &event))
+        {
+            std::vector<EntryMeta> entries;
+            data.scan_finished = takeScanResults(&data.scan, &entries);
+            insertEntries(&entries, entryCount(&data.entries), &data);
+            countScanned(entries.size(), &data);
+            dirty = true;
+
+            //changes seen while loading are applied on top of the finished listing
+            if(data.scan_finished)
+            {
+                applyChanges(renderer, &data);
+                if(!isPathOrder(data.sort_order))
+                {
+                    resortEntries(&data);
+                }
+                startSizes(&data);
+            }
+        }
+
+        //directory totals grew or finished
+        if(isCurrentSizes(&data.sizes, &event))
+        {
+            bool finished = takeSizeUpdate(&data.sizes);
+            applySizes(&data);
+            dirty = true;
+            if(finished && data.sort_order.key == SORT_SIZE)
+            {
+                resortEntries(&data);
+            }
+        }
+
+        //icons of files whose contents were sniffed
+        if(applySniffedTypes(&event, &data))
+        {
+            dirty = true;
+        }
+
+        //rows of a directory being expanded
+        if(applyExpansion(renderer, &event, &data))
+        {
+            dirty = true;
+        }
+
+        //decoded thumbnails, a few uploaded per frame
+        if(data.thumbnails && event.type == data.thumbs.queue->event_type && uploadThumbnails(renderer, &data.thumbs))
+        {
+            dirty = true;
+        }
+
+        //an opened file's handler exited; queued files start in its place
+        reapChildren(&data.launcher, &event);
+
+        //copy, move or delete progress; a finished job makes way for the next
+        if(updateTransfers(&data.transfers, &event))
+        {
+            dirty = true;
+        }
+
+        //duplicate search progress, or its groups
+        if(applyDuplicates(&event, &data))
+        {
+            dirty = true;
+        }
+
+        //files created, deleted, renamed or modified on disk [held back while anything is still loading]
+        if(event.type == data.watch.event_type && data.scan_finished && data.expansions.empty())
+        {
+            applyChanges(renderer, &data);
+            dirty = true;
+        }
+
         switch (event.type)
         {
         case SDL_MOUSEMOTION:
+            //plain pointer movement changes nothing on screen
             if(data.scrollbar_selected){
-                data.scrollbar.y = event.motion.y - data.scrollbar_offset.y;
-                
-                //change icon/file/size/permissions y positions
-                if(moving) {
-                    for(int i = 0; i < data.name_coordinates.size(); i++)
-                    {
-                        int pos = data.y_origin[i].y - (event.motion.y - motion_root)*8;
-                        data.name_coordinates[i].y = pos;
-                        data.icon_coordinates[i].y = pos;
-                        data.permissions_coordinates[i].y = pos;
-                        data.size_coordinates[i].y = pos;
-                    }
+                dirty = true;
+                dragScrollbar(event.motion.y, &data);
+            }
+            break;
+
+        case SDL_MOUSEWHEEL:
+            flingScroll(event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -event.wheel.y : event.wheel.y, &data);
+            dirty = true;
+            break;
+        
+        case SDL_TEXTINPUT:
+            if(data.filter_focused)
+            {
+                dirty = true;
+                setFilterText(data.filter_text + event.text.text, data.filter.fuzzy, &data);
+            }
+            break;
+
+        case SDL_KEYDOWN:
+            dirty = true;
+            //a pending delete needs the very next key to be Delete
+            if(event.key.keysym.sym != SDLK_DELETE)
+            {
+                data.delete_armed = false;
+            }
+            //F3 shows frame timing, F12 starts a trace or writes the running one
+            if(event.key.keysym.sym == SDLK_F3)
+            {
+                data.hud_visible = !data.hud_visible;
+            }
+            else if(event.key.keysym.sym == SDLK_F12)
+            {
+                if(!trace_enabled) {
+                    startTrace();
+                    std::cout << "Tracing, F12 again writes " << trace_file << std::endl;
+                } else if(writeTrace(trace_file)) {
+                    std::cout << "Trace written to " << trace_file << std::endl;
                 }
             }
-            if(data.scrollbar.y < 32){
-                data.scrollbar.y = 32;
-                moving = false;
-            } else if(data.scrollbar.y + data.scrollbar.h > 593){
-                data.scrollbar.y = 593-data.scrollbar.h;
-                moving = false;
-            } else {
-                moving = true;
+            //Ctrl+F jumps to the filter box
+            if(event.key.keysym.sym == SDLK_f && (event.key.keysym.mod & KMOD_CTRL))
+            {
+                data.filter_focused = true;
+                SDL_StartTextInput();
+            }
+            else if(data.filter_focused && event.key.keysym.sym == SDLK_BACKSPACE && !data.filter_text.empty())
+            {
+                //drop the last character, with all of its UTF-8 bytes
+                std::string text = data.filter_text;
+                int end = text.length() - 1;
+                while(end > 0 && (text.at(end) & 0xC0) == 0x80)
+                {
+                    end--;
+                }
+                setFilterText(text.substr(0, end), data.filter.fuzzy, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_BACKSPACE && !data.filter_focused)
+            {
+                //Backspace outside the filter goes up a directory [in the box it only ever edits, even when empty]
+                openParent(renderer, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_UP || event.key.keysym.sym == SDLK_DOWN)
+            {
+                //arrows move the cursor, shift extends the selection, ctrl moves without selecting
+                Uint16 mod = event.key.keysym.mod;
+                int mode = (mod & KMOD_CTRL) ? SELECT_NONE : (mod & KMOD_SHIFT) ? SELECT_EXTEND : SELECT_ONLY;
+                moveCursor(event.key.keysym.sym == SDLK_UP ? -1 : 1, mode, &data);
+            }
+            else if((event.key.keysym.sym == SDLK_LEFT || event.key.keysym.sym == SDLK_RIGHT) && !data.filter_focused)
+            {
+                expandCursor(event.key.keysym.sym == SDLK_RIGHT, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_SPACE && (event.key.keysym.mod & KMOD_CTRL) && data.selection.cursor >= 0)
+            {
+                selectRow(entryRow(data.selection.cursor, &data), SELECT_TOGGLE, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_a && (event.key.keysym.mod & KMOD_CTRL) && !data.filter_focused)
+            {
+                selectAll(&data);
+            }
+            else if((event.key.keysym.sym == SDLK_RETURN || event.key.keysym.sym == SDLK_KP_ENTER) && data.selection.cursor >= 0)
+            {
+                openEntry(renderer, data.selection.cursor, &data);
+            }
+            else if(data.filter_focused && event.key.keysym.sym == SDLK_TAB)
+            {
+                //Tab switches between substring and fuzzy matching
+                setFilterText(data.filter_text, !data.filter.fuzzy, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_PAGEUP || event.key.keysym.sym == SDLK_PAGEDOWN)
+            {
+                scrollPage(event.key.keysym.sym == SDLK_PAGEUP ? -1 : 1, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_HOME || event.key.keysym.sym == SDLK_END)
+            {
+                data.scroll_velocity = 0;
+                scrollTo(event.key.keysym.sym == SDLK_HOME ? 0 : maxScroll(&data), &data);
+            }
+            else if(data.filter_focused && event.key.keysym.sym == SDLK_ESCAPE)
+            {
+                setFilterText("", data.filter.fuzzy, &data);
+                data.filter_focused = false;
+                SDL_StopTextInput();
+            }
+            //Ctrl+C and Ctrl+X pick up the selection, Ctrl+V copies or moves it here, Delete twice deletes it, Esc cancels
+            else if((event.key.keysym.sym == SDLK_c || event.key.keysym.sym == SDLK_x) && (event.key.keysym.mod & KMOD_CTRL) && !data.filter_focused)
+            {
+                copySelection(event.key.keysym.sym == SDLK_c ? TRANSFER_COPY : TRANSFER_MOVE, &data);
+            }
+            else if(event.key.keysym.sym == SDLK_v && (event.key.keysym.mod & KMOD_CTRL) && !data.filter_focused)
+            {
+                pasteClipboard(&data);
+            }
+            //Ctrl+D looks for duplicate files in the listing, and leaves their view again
+            else if(event.key.keysym.sym == SDLK_d && (event.key.keysym.mod & KMOD_CTRL) && !data.filter_focused)
+            {
+                toggleDuplicates(&data);
+            }
+            else if(event.key.keysym.sym == SDLK_DELETE && !data.filter_focused)
+            {
+                deleteSelection(&data);
+            }
+            else if(event.key.keysym.sym == SDLK_ESCAPE)
+            {
+                cancelTransfers(&data.transfers);
             }
             break;
-        
+
         case SDL_MOUSEBUTTONDOWN:
-            //Scrollbar
-            if (event.button.button == SDL_BUTTON_LEFT &&
-                event.button.x >= data.scrollbar.x &&
-                event.button.x <= data.scrollbar.x + data.scrollbar.w &&
-                event.button.y >= data.scrollbar.y &&
-                event.button.y <= data.scrollbar.y + data.scrollbar.h)
+            dirty = true;
+            //Filter box takes typing while it has focus
+            if (event.button.button == SDL_BUTTON_LEFT)
+            {
+                data.filter_focused = onRect(event.button.x, event.button.y, &data.filter_box);
+                if(data.filter_focused) {
+                    SDL_StartTextInput();
+                } else {
+                    SDL_StopTextInput();
+                }
+            }
+            //Scrollbar: drag the thumb, or page towards a click on the track
+            if (event.button.button == SDL_BUTTON_LEFT && onRect(event.button.x, event.button.y, &data.scrollbar))
             {
                 data.scrollbar_selected = true;
                 data.scrollbar_offset.y = event.button.y - data.scrollbar.y;
-
-                motion_root = event.motion.y;
-
-                //set general y offset
-                for(int i = 0; i < data.name_coordinates.size(); i++)
-                {
-                    data.y_origin[i].y = data.name_coordinates[i].y;
-                }
-                moving = true;
+                data.scroll_velocity = 0;
                 SDL_CaptureMouse(SDL_TRUE);
             }
+            else if (event.button.button == SDL_BUTTON_LEFT && onRect(event.button.x, event.button.y, &data.scrollbar_outline))
+            {
+                scrollPage(event.button.y < data.scrollbar.y ? -1 : 1, &data);
+            }
             //Recursive Button
             if (event.button.button == SDL_BUTTON_LEFT &&
                 event.button.x >= data.recursive_button_outline.x &&
@@ -177,74 +502,89 @@ int main(int argc, char **argv)
                 event.button.y <= data.recursive_button_outline.y + data.recursive_button_outline.h)
             {
                 data.recursive_viewing_mode = !data.recursive_viewing_mode;
-                cleanTextures(&data);
+                cleanEntries(&data);
                 initialize(renderer, &data);
             }
-            //Select File or Directory
-            for(int i = 0; i < data.name_text.size(); i++) 
-            {
-                if (event.button.button == SDL_BUTTON_LEFT &&
-                    //name click
-                    ((event.button.x >= data.name_coordinates[i].x &&
-                    event.button.x <= data.name_coordinates[i].x + data.name_coordinates[i].w &&
-                    event.button.y >= data.name_coordinates[i].y &&
-                    event.button.y <= data.name_coordinates[i].y + data.name_coordinates[i].h) ||
-                    //icon click
-                    (event.button.x >= data.icon_coordinates[i].x &&
-                    event.button.x <= data.icon_coordinates[i].x + data.icon_coordinates[i].w &&
-                    event.button.y >= data.icon_coordinates[i].y &&
-                    event.button.y <= data.icon_coordinates[i].y + data.icon_coordinates[i].h)))
+            //Sort by a column: click again to reverse, shift-click Name for type and Size for modification time
+            if (event.button.button == SDL_BUTTON_LEFT)
+            {
+                bool shift = (SDL_GetModState() & KMOD_SHIFT) != 0;
+                if(onRect(event.button.x, event.button.y, &data.name_header_coordinates)) {
+                    setSortOrder(shift ? SORT_TYPE : SORT_NAME, &data);
+                } else if(onRect(event.button.x, event.button.y, &data.size_header_coordinates)) {
+                    setSortOrder(shift ? SORT_MTIME : SORT_SIZE, &data);
+                } else if(onRect(event.button.x, event.button.y, &data.permissions_header_coordinates)) {
+                    setSortOrder(SORT_PERMISSIONS, &data);
+                }
+            }
+            //Expand or collapse a directory in place
+            if (event.button.button == SDL_BUTTON_LEFT && expanderAt(event.button.x, event.button.y, &data) >= 0)
+            {
+                toggleEntry(expanderAt(event.button.x, event.button.y, &data), &data);
+            }
+            //Select File or Directory [the row comes straight from the click position]
+            //a click selects, ctrl-click adds or removes, shift-click selects a range, a double click opens
+            else if (event.button.button == SDL_BUTTON_LEFT)
+            {
+                int row = rowAt(event.button.x, event.button.y, &data);
+                if(row >= 0)
                 {
-                    //if [i] is a directory
-                    if(data.icon_type[i] == 0)
+                    SDL_Keymod mod = SDL_GetModState();
+                    int mode = (mod & KMOD_CTRL) ? SELECT_TOGGLE : (mod & KMOD_SHIFT) ? SELECT_EXTEND : SELECT_ONLY;
+                    selectRow(row, mode, &data);
+                    if(mode == SELECT_ONLY && event.button.clicks >= 2)
                     {
-                        data.directory = data.name[i];
-                        cleanTextures(&data);
-                        initialize(renderer, &data);
-                    }
-                    else //[i] is a not a directory
-                    {
-                                                                        //CODE FOR OPENING FILES HERE
-                        //file type can be determined by its icon type as shown in the above *if* statement
-                        //0 is directory, 1 is executable, 2 is image, 3 is video, 4 is code file, and 5 is other
-                        //data.name vector contains file paths
-
-                        int pid = fork();
-
-                        // child command opens file
-                        if(pid == 0)
-                        {
-                            char *pathstr = new char[data.name[i].length() + 1];
-                            strcpy(pathstr, data.name[i].c_str());
-
-                            char *xdgstr = new char[9];
-                            strcpy(xdgstr, "xdg-open");
-
-                            char *passes[3] = {xdgstr, pathstr, NULL};
-
-                            execvp(xdgstr, passes);
-                        }
-                        // parent continues running file application
+                        openEntry(renderer, rowEntry(row, &data), &data);
                     }
                 }
             }
             break;
         
         case SDL_MOUSEBUTTONUP:
+            dirty = dirty || data.scrollbar_selected;
             data.scrollbar_selected = false;
             SDL_CaptureMouse(SDL_FALSE);
             break;
+        case SDL_WINDOWEVENT:
+            //exposed, restored or resized windows need their contents back
+            dirty = true;
+            break;
+
         default:
             break;
         }
-
-        render(renderer, &data);
     }
 
     // clean up
-    cleanTextures(&data);
+    if(trace_env != NULL && trace_env[0] != '\0')
+    {
+        writeTrace(trace_file);
+    }
+    cancelDirectoryScan(&data.scan);
+    cancelExpansions(&data);
+    cancelDuplicateSearch(&data.duplicates);
+    cancelSniffing(&data.sniffing);
+    cancelDirectorySizes(&data.sizes);
+    stopIndexRefresh(&data.index_refresh);
+    stopWatch(&data.watch);
+    stopLauncher(&data.launcher);
+    cleanTransfers(&data.transfers);
+    cleanEntries(&data);
     cleanIcons(&data);
+    if(data.thumbnails)
+    {
+        cleanThumbnails(&data.thumbs);
+    }
+    cleanGlyphAtlas(&data.text);
     TTF_CloseFont(data.font);
+    destroyThreadPool(data.background);
+    destroyThreadPool(data.pool);
+
+    //cache effectiveness, for tuning --cache-mb
+    CacheStats cache_stats = getCacheStats(&data.cache);
+    std::cout << "Cache: " << cache_stats.hits << " hits, " << cache_stats.index_hits << " index hits, " << cache_stats.misses << " misses, "
+              << cache_stats.evictions << " evictions, " << cache_stats.listings << " listings in "
+              << cache_stats.bytes/1024 << " KiB" << std::endl;
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     IMG_Quit();
@@ -253,454 +593,3 @@ int main(int argc, char **argv)
 
     return 0;
 }
-
-
-void initialize(SDL_Renderer *renderer, AppData *data_ptr)
-{
-    // set color of background when erasing frame
-    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
-
-    //load font
-    data_ptr->font = TTF_OpenFont("resrc/OpenSans-Regular.ttf", 18);
-
-
-    //Create Header
-    data_ptr->header_box = {0,0,800,25};
-    SDL_Color phrase_color = { 0, 0, 0 };
-    //Set text
-    SDL_Surface *header_surf = TTF_RenderText_Solid(data_ptr->font, "Name", phrase_color);
-    data_ptr->name_header = SDL_CreateTextureFromSurface(renderer, header_surf);
-    header_surf = TTF_RenderText_Solid(data_ptr->font, "Size", phrase_color);
-    data_ptr->size_header = SDL_CreateTextureFromSurface(renderer, header_surf);
-    header_surf = TTF_RenderText_Solid(data_ptr->font, "Permissions", phrase_color);
-    data_ptr->permissions_header = SDL_CreateTextureFromSurface(renderer, header_surf);
-    SDL_FreeSurface(header_surf);
-    //Set coordinates
-    int size_pos_x = 500;
-    int permissions_pos_x = 570;
-    data_ptr->name_header_coordinates.x = 50;
-    data_ptr->name_header_coordinates.y = 0;
-    SDL_QueryTexture(data_ptr->name_header, NULL, NULL, &(data_ptr->name_header_coordinates.w), &(data_ptr->name_header_coordinates.h));
-    data_ptr->size_header_coordinates.x = size_pos_x;
-    data_ptr->size_header_coordinates.y = 0;
-    SDL_QueryTexture(data_ptr->size_header, NULL, NULL, &(data_ptr->size_header_coordinates.w), &(data_ptr->size_header_coordinates.h));
-    data_ptr->permissions_header_coordinates.x = permissions_pos_x;
-    data_ptr->permissions_header_coordinates.y = 0;
-    SDL_QueryTexture(data_ptr->permissions_header, NULL, NULL, &(data_ptr->permissions_header_coordinates.w), &(data_ptr->permissions_header_coordinates.h));
-
-    //Create Recursive Mode Button
-    data_ptr->recursive_button_outline = {778,3,19,19};
-    data_ptr->recursive_button = {782,7,11,11};
-    SDL_Surface *button_surf = TTF_RenderText_Solid(data_ptr->font, "All Files:", phrase_color);
-    data_ptr->button_text = SDL_CreateTextureFromSurface(renderer, button_surf);
-    SDL_FreeSurface(button_surf);
-    data_ptr->button_text_coordinates.x = 705;
-    data_ptr->button_text_coordinates.y = 0;
-    SDL_QueryTexture(data_ptr->button_text, NULL, NULL, &(data_ptr->button_text_coordinates.w), &(data_ptr->button_text_coordinates.h));
-
-
-    //Get Directory files
-    std::string dir = data_ptr->directory;
-    int slash_count = slashCount(dir);
-    getFileData(dir, data_ptr);
-
-
-    //y_origin here is not associated with the data field in AppData
-    int y_origin = 25;
-    int icon_side_length;
-    int icon_gap = 2;
-    for(int i = 0; i < data_ptr->name.size(); i++)
-    {
-        //For each folder in directory: create text, permissions, size, and position variables
-        SDL_Texture *text;
-        SDL_Rect icon_pos;
-        SDL_Rect text_pos;
-        SDL_Texture *size;
-        SDL_Rect size_pos;
-        SDL_Texture *permissions;
-        SDL_Rect perm_pos;
-        data_ptr->name_coordinates.push_back(text_pos);
-        data_ptr->name_text.push_back(text);
-        data_ptr->icon_coordinates.push_back(icon_pos);
-        data_ptr->size_text.push_back(size);
-        data_ptr->size_coordinates.push_back(size_pos);
-        data_ptr->permissions_text.push_back(permissions);
-        data_ptr->permissions_coordinates.push_back(perm_pos);
-
-        //get file name
-        fs::path fp = data_ptr->name.at(i);
-        std::string name = fp.filename();
-
-        //Set text
-        SDL_Surface *text_surf = TTF_RenderText_Solid(data_ptr->font, name.c_str(), phrase_color);
-        data_ptr->name_text.at(i) = SDL_CreateTextureFromSurface(renderer, text_surf);
-        text_surf = TTF_RenderText_Solid(data_ptr->font, data_ptr->size.at(i).c_str(), phrase_color);
-        data_ptr->size_text.at(i) = SDL_CreateTextureFromSurface(renderer, text_surf);
-        text_surf = TTF_RenderText_Solid(data_ptr->font, data_ptr->permissions.at(i).c_str(), phrase_color);
-        data_ptr->permissions_text.at(i) = SDL_CreateTextureFromSurface(renderer, text_surf);
-        SDL_FreeSurface(text_surf);
-        
-        //Set Coordinates
-        int indents = slashCount(data_ptr->name.at(i)) - slash_count - 1;
-
-        data_ptr->name_coordinates.at(i).x = 50 + (25*indents);
-        data_ptr->name_coordinates.at(i).y = y_origin;
-        SDL_QueryTexture(data_ptr->name_text.at(i), NULL, NULL, &(data_ptr->name_coordinates.at(i).w), &(data_ptr->name_coordinates.at(i).h));
-        data_ptr->size_coordinates.at(i).x = size_pos_x;
-        data_ptr->size_coordinates.at(i).y = y_origin;
-        SDL_QueryTexture(data_ptr->size_text.at(i), NULL, NULL, &(data_ptr->size_coordinates.at(i).w), &(data_ptr->size_coordinates.at(i).h));
-        data_ptr->permissions_coordinates.at(i).x = permissions_pos_x;
-        data_ptr->permissions_coordinates.at(i).y = y_origin;
-        SDL_QueryTexture(data_ptr->permissions_text.at(i), NULL, NULL, &(data_ptr->permissions_coordinates.at(i).w), &(data_ptr->permissions_coordinates.at(i).h));
-
-        icon_side_length = data_ptr->name_coordinates.at(i).h - icon_gap*2;
-
-        //set icon dimensions
-        data_ptr->icon_coordinates.at(i).x = 25 + icon_gap;
-        data_ptr->icon_coordinates.at(i).y = y_origin + icon_gap;
-        data_ptr->icon_coordinates.at(i).w = icon_side_length;
-        data_ptr->icon_coordinates.at(i).h = icon_side_length;
-
-        y_origin += data_ptr->name_coordinates.at(i).h;
-    }
-
-
-    //Create Scrollbar [23 items fit on a page]
-    data_ptr->scrollbar_outline = {2,27,21,571};
-    int items = data_ptr->name_text.size();
-    data_ptr->scrollbar_selected = false;
-    //populate y offset vector
-    for(int i = 0; i < data_ptr->name_coordinates.size(); i++)
-    {
-        SDL_Point point;
-        data_ptr->y_origin.push_back(point);
-    }
-
-    //get scrollbar size based on how many files there are
-    if(items < 23) {
-        data_ptr->scrollbar = {7,32,11,561};
-    } else {
-        int height = (561*23)/(items);
-        data_ptr->scrollbar = {7,32,11,height};
-    }
-}
-
-void render(SDL_Renderer *renderer, AppData *data_ptr)
-{
-    // erase renderer content
-    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
-    SDL_RenderClear(renderer);
-
-
-    //Draw
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderDrawRect(renderer, &data_ptr->scrollbar_outline);
-    SDL_RenderFillRect(renderer, &data_ptr->scrollbar);
-
-    
-    
-    for(int i = 0; i < data_ptr->name_text.size(); i++) {
-        //determine correct folder type
-        SDL_RenderCopy(renderer, data_ptr->icon.at(data_ptr->icon_type.at(i)), NULL, &(data_ptr->icon_coordinates.at(i)));
-        SDL_RenderCopy(renderer, data_ptr->name_text.at(i), NULL, &(data_ptr->name_coordinates.at(i)));
-        SDL_RenderCopy(renderer, data_ptr->size_text.at(i), NULL, &(data_ptr->size_coordinates.at(i)));
-        SDL_RenderCopy(renderer, data_ptr->permissions_text.at(i), NULL, &(data_ptr->permissions_coordinates.at(i)));
-    }
-
-    //Header
-    SDL_SetRenderDrawColor(renderer, 235, 235, 235, 255);
-    SDL_RenderFillRect(renderer, &data_ptr->header_box);
-    SDL_RenderCopy(renderer, data_ptr->name_header, NULL, &(data_ptr->name_header_coordinates));
-    SDL_RenderCopy(renderer, data_ptr->size_header, NULL, &(data_ptr->size_header_coordinates));
-    SDL_RenderCopy(renderer, data_ptr->permissions_header, NULL, &(data_ptr->permissions_header_coordinates));
-
-    //Recursive Button
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderDrawRect(renderer, &data_ptr->recursive_button_outline);
-    if(data_ptr->recursive_viewing_mode) {
-        SDL_RenderFillRect(renderer, &data_ptr->recursive_button);
-    }
-    SDL_RenderCopy(renderer, data_ptr->button_text, NULL, &(data_ptr->button_text_coordinates));
-
-    // show rendered frame
-    SDL_RenderPresent(renderer);
-}
-
-void cleanTextures(AppData *data_ptr)
-{
-    for(int i = 0; i < data_ptr->name_text.size(); i++)
-    {
-        //file data textures
-        SDL_DestroyTexture(data_ptr->name_text.at(i));
-        SDL_DestroyTexture(data_ptr->permissions_text.at(i));
-        SDL_DestroyTexture(data_ptr->size_text.at(i));
-    }
-    //header
-    SDL_DestroyTexture(data_ptr->size_header);
-    SDL_DestroyTexture(data_ptr->name_header);
-    SDL_DestroyTexture(data_ptr->permissions_header);
-    SDL_DestroyTexture(data_ptr->button_text);
-
-    //data vectors
-    data_ptr->name.clear();
-    data_ptr->name_text.clear();
-    data_ptr->icon_type.clear();
-    data_ptr->permissions.clear();
-    data_ptr->size.clear();
-    data_ptr->y_origin.clear();
-    //coordinate vectors
-    data_ptr->icon_coordinates.clear();
-    data_ptr->name_coordinates.clear();
-    data_ptr->size_coordinates.clear();
-    data_ptr->permissions_coordinates.clear();
-}
-
-void cleanIcons(AppData *data_ptr)
-{
-    SDL_DestroyTexture(data_ptr->icon.at(0));
-    SDL_DestroyTexture(data_ptr->icon.at(1));
-    SDL_DestroyTexture(data_ptr->icon.at(2));
-    SDL_DestroyTexture(data_ptr->icon.at(3));
-    SDL_DestroyTexture(data_ptr->icon.at(4));
-    SDL_DestroyTexture(data_ptr->icon.at(5));
-}
-
-void initializeIcons(SDL_Renderer *renderer, AppData *data_ptr)
-{
-    //Directory: index 0 in icon vector
-    SDL_Surface *surf = IMG_Load("resrc/images/directory.png");
-    SDL_Texture *icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    //Executable: index 1 in icon vector
-    surf = IMG_Load("resrc/images/executable.png");
-    icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    //Image: index 2 in icon vector
-    surf = IMG_Load("resrc/images/image.png");
-    icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    //Video: index 3 in icon vector
-    surf = IMG_Load("resrc/images/video.png");
-    icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    //Code File: index 4 in icon vector
-    surf = IMG_Load("resrc/images/code_file.png");
-    icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    //Other: index 5 in icon vector
-    surf = IMG_Load("resrc/images/other.png");
-    icon = SDL_CreateTextureFromSurface(renderer, surf);
-    data_ptr->icon.push_back(icon);
-
-    SDL_FreeSurface(surf);
-}
-
-void getFileData(std::string dirname, AppData *data_ptr)
-{
-    //set file names
-    data_ptr->name = listDirectory(dirname, data_ptr->recursive_viewing_mode);
-
-    data_ptr->name.insert(data_ptr->name.begin(), dirname + "/..");
-
-    //set file types, permissions, and sizes
-    for(int i = 0; i < data_ptr->name.size(); i++)
-    {
-        //file path/name
-        fs::path fp = data_ptr->name.at(i);
-        std::string file = fp.filename();     
-
-
-        //permissions
-        data_ptr->permissions.push_back(getPermissions(fs::status(fp).permissions()));
-
-        //size
-        std::string bytes = "-";
-        if(!fs::is_directory(fp)){
-            int size = fs::file_size(fp);
-            if(size < 1024){
-                bytes = std::to_string(size) + " B";
-            } else if(size < 1048567) {
-                size = size/1024;
-                bytes = std::to_string(size) + " KiB";
-            } else if(size < 1073741824) {
-                size = size/1048567;
-                bytes = std::to_string(size) + " MiB";
-            } else {
-                size = size/1073741824;
-                bytes = std::to_string(size) + " GiB";
-            }
-        }
-        data_ptr->size.push_back(bytes);
-
-
-        //file type
-        if(fs::is_directory(fp)) {//file is a directory, icon array index 0
-            data_ptr->icon_type.push_back(0);
-        } else if (((fs::status(fp).permissions() & fs::perms::owner_exec) != fs::perms::none) ||
-                   ((fs::status(fp).permissions() & fs::perms::group_exec) != fs::perms::none) ||
-                   ((fs::status(fp).permissions() & fs::perms::others_exec) != fs::perms::none)) {//file is an executable, icon array index 1
-            data_ptr->icon_type.push_back(1);
-        } else if ((file.find(".jpg") != std::string::npos) ||
-                    (file.find(".jpeg") != std::string::npos) ||
-                    (file.find(".png") != std::string::npos) ||
-                    (file.find(".tif") != std::string::npos) ||
-                    (file.find(".tiff") != std::string::npos) ||
-                    (file.find(".gif") != std::string::npos)) {//file is an image, icon array index 2
-            data_ptr->icon_type.push_back(2);
-        } else if ((file.find(".mp4") != std::string::npos) ||
-                    (file.find(".mov") != std::string::npos) ||
-                    (file.find(".mkv") != std::string::npos) ||
-                    (file.find(".avi") != std::string::npos) ||
-                    (file.find(".webm") != std::string::npos)) {//file is a video, icon array index 3
-            data_ptr->icon_type.push_back(3);
-        } else if ((file.find(".h") != std::string::npos) ||
-                    (file.find(".c") != std::string::npos) ||
-                    (file.find(".cpp") != std::string::npos) ||
-                    (file.find(".py") != std::string::npos) ||
-                    (file.find(".java") != std::string::npos) ||
-                    (file.find(".js") != std::string::npos)) {//file is a code file, icon array index 4
-            data_ptr->icon_type.push_back(4);
-        } else {//file is other, icon array index 5
-            data_ptr->icon_type.push_back(5);
-        }
-    }
-}
-
-std::vector<std::string> listDirectory(std::string dirname, bool recurse)
-{
-    struct stat info;
-
-    std::vector<std::string> files;
-    
-    int err = stat(dirname.c_str(), &info);
-    if (err == 0 && S_ISDIR(info.st_mode))
-    {
-        DIR* dir = opendir(dirname.c_str());
-
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-
-            files.push_back(entry->d_name);
-            if(files.back() == "." || files.back() == ".."){
-                files.pop_back();
-            }
-        }
-        closedir(dir);
-    }
-    else
-    {
-        fprintf(stderr, "Error: directory '%s' not found\n", dirname.c_str());
-    }
-
-    //sort
-    std::sort(files.begin(), files.end(), compareNoCase);
-
-    //std::cout << files.size() << std::endl;
-    for(int i = 0; i < files.size(); i++)
-    { 
-        files.at(i) = dirname + "/" + files.at(i);
-    }
-
-    for(int i = 0; i < files.size(); i++)
-    {        
-        fs::path fp = files.at(i);
-
-        std::string file = fp.filename();
-
-        //find subDirectories if recursive viewing is active
-        if(fs::is_directory(fp) && recurse && file.at(0) != '.')
-        {
-            //std::cout << i << std::endl;
-            std::vector<std::string> subDirectory = listDirectory(files.at(i), false);
-            files.insert(files.begin() + i + 1, subDirectory.begin(), subDirectory.end());
-        }
-    }
-
-    return files;
-}
-
-std::string getPermissions(fs::perms p)
-{
-    std::string ret = "";
-
-    //owner
-    if((p & fs::perms::owner_read) != fs::perms::none){
-        ret += "r";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::owner_write) != fs::perms::none){
-        ret += "w";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::owner_exec) != fs::perms::none){
-        ret += "x";
-    } else {
-        ret += "-";
-    }
-    //group
-    if((p & fs::perms::group_read) != fs::perms::none){
-        ret += "r";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::group_write) != fs::perms::none){
-        ret += "w";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::group_exec) != fs::perms::none){
-        ret += "x";
-    } else {
-        ret += "-";
-    }
-    //others
-    if((p & fs::perms::others_read) != fs::perms::none){
-        ret += "r";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::others_write) != fs::perms::none){
-        ret += "w";
-    } else {
-        ret += "-";
-    }
-    if((p & fs::perms::others_exec) != fs::perms::none){
-        ret += "x";
-    } else {
-        ret += "-";
-    }
-    return ret;
-}
-
-bool compareNoCase (std::string first, std::string second)
-{
-  int i=0;
-  while ((i < first.length()) && (i < second.length()))
-  {
-    if (tolower (first[i]) < tolower (second[i])) return true;
-    else if (tolower (first[i]) > tolower (second[i])) return false;
-    i++;
-  }
-
-  if (first.length() < second.length()) return true;
-  else return false;
-}
-
-int slashCount(std::string path)
-{
-    char slash = '/';
-    int slash_count = 0;
-
-    for (int i = 0; (i = path.find(slash, i)) != std::string::npos; i++) {
-        slash_count++;
-    }
-
-    return slash_count;
-}
\ No newline at end of file
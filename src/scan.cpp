@@ -0,0 +1,123 @@
+#include "scan.h"
+#include "trace.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+bool statOnce(int dirfd, const char *name, int flags, EntryMeta *entry, ScanStats *stats);
+
+int scanDirectory(const std::string &dirname, int fields, std::vector<EntryMeta> *entries, ScanStats *stats)
+{
+    TraceScope scope("readdir");
+    int first = entries->size();
+    int fd = open(dirname.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -errno;
+    }
+    DIR *dir = fdopendir(fd);
+    if(dir == NULL)
+    {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    if(stats != NULL)
+    {
+        stats->directories++;
+    }
+
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        const char *name = entry->d_name;
+        if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            continue;
+        }
+
+        EntryMeta meta;
+        meta.path = name;
+        meta.mode = 0;
+        meta.size = 0;
+        meta.mtime = 0;
+        meta.is_directory = (entry->d_type == DT_DIR);
+        meta.is_link = (entry->d_type == DT_LNK);
+
+        //d_type is enough unless metadata was asked for, or the type is unknown or a symlink to follow
+        bool need_stat = (fields & SCAN_METADATA) || entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK;
+        if(need_stat)
+        {
+            statEntry(fd, name, &meta, stats);
+        }
+        else
+        {
+            meta.mode = DTTOIF(entry->d_type);
+        }
+        entries->push_back(meta);
+        if(stats != NULL)
+        {
+            stats->entries++;
+        }
+    }
+    closedir(dir);
+    scope.value = entries->size() - first;
+    return 0;
+}
+
+bool statEntry(int dirfd, const char *name, EntryMeta *entry, ScanStats *stats)
+{
+    TRACE_SCOPE("stat");
+    //the entry itself first, so a symlink is known as one even where readdir gives no d_type
+    //[the walker never descends a link]; skipped when d_type already said symlink
+    if(!entry->is_link)
+    {
+        if(!statOnce(dirfd, name, AT_SYMLINK_NOFOLLOW, entry, stats))
+        {
+            return false;
+        }
+        entry->is_link = S_ISLNK(entry->mode);
+        if(!entry->is_link)
+        {
+            return true;
+        }
+    }
+    //a symlink shows its target like fs::status(); a dangling link keeps the link itself
+    if(statOnce(dirfd, name, 0, entry, stats))
+    {
+        return true;
+    }
+    return S_ISLNK(entry->mode) || statOnce(dirfd, name, AT_SYMLINK_NOFOLLOW, entry, stats);
+}
+
+bool statOnce(int dirfd, const char *name, int flags, EntryMeta *entry, ScanStats *stats)
+{
+    if(stats != NULL)
+    {
+        stats->stat_calls++;
+    }
+#ifdef STATX_TYPE
+    struct statx info;
+    if(statx(dirfd, name, flags | AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME, &info) != 0)
+    {
+        return false;
+    }
+    entry->mode = info.stx_mode;
+    entry->size = info.stx_size;
+    entry->mtime = info.stx_mtime.tv_sec;
+#else
+    struct stat info;
+    if(fstatat(dirfd, name, &info, flags) != 0)
+    {
+        return false;
+    }
+    entry->mode = info.st_mode;
+    entry->size = info.st_size;
+    entry->mtime = info.st_mtime;
+#endif
+    entry->is_directory = S_ISDIR(entry->mode);
+    return true;
+}
@@ -0,0 +1,163 @@
+#include "selection.h"
+#include <algorithm>
+
+uint64_t getBits(const std::vector<uint64_t> &bits, size_t position, int length);
+void setBits(std::vector<uint64_t> *bits, size_t position, uint64_t value, int length);
+void copyBits(const std::vector<uint64_t> &source, size_t from, std::vector<uint64_t> *target, size_t to, size_t length);
+
+void resetSelection(Selection *selection)
+{
+    selection->bits.clear();
+    selection->count = 0;
+    selection->cursor = -1;
+    selection->anchor = -1;
+}
+
+void insertSelectionRows(Selection *selection, int position, int count)
+{
+    //new rows start unselected; everything after them moves down a word at a time
+    std::vector<uint64_t> bits((selection->count + count + 63)/64, 0);
+    copyBits(selection->bits, 0, &bits, 0, position);
+    copyBits(selection->bits, position, &bits, position + count, selection->count - position);
+    selection->bits.swap(bits);
+    selection->count += count;
+    if(selection->cursor >= position)
+    {
+        selection->cursor += count;
+    }
+    if(selection->anchor >= position)
+    {
+        selection->anchor += count;
+    }
+}
+
+void removeSelectionRows(Selection *selection, int position, int count)
+{
+    std::vector<uint64_t> bits((selection->count - count + 63)/64, 0);
+    copyBits(selection->bits, 0, &bits, 0, position);
+    copyBits(selection->bits, position + count, &bits, position, selection->count - position - count);
+    selection->bits.swap(bits);
+    selection->count -= count;
+
+    //a removed cursor lands on the row that took its place
+    int *marks[2] = {&selection->cursor, &selection->anchor};
+    for(int m = 0; m < 2; m++)
+    {
+        if(*marks[m] >= position + count) {
+            *marks[m] -= count;
+        } else if(*marks[m] >= position) {
+            *marks[m] = std::min(position, selection->count - 1);
+        }
+    }
+}
+
+void permuteSelection(Selection *selection, const std::vector<int> &order)
+{
+    //row i now holds the entry that was at order[i]
+    bool any = std::any_of(selection->bits.begin(), selection->bits.end(), [](uint64_t word) { return word != 0; });
+    std::vector<uint64_t> bits(selection->bits.size(), 0);
+    int cursor = -1;
+    int anchor = -1;
+    for(int i = 0; i < order.size(); i++)
+    {
+        int old = order.at(i);
+        if(any && ((selection->bits.at(old/64) >> (old%64)) & 1))
+        {
+            bits.at(i/64) |= (uint64_t)1 << (i%64);
+        }
+        cursor = (old == selection->cursor) ? i : cursor;
+        anchor = (old == selection->anchor) ? i : anchor;
+    }
+    selection->bits.swap(bits);
+    selection->cursor = cursor;
+    selection->anchor = anchor;
+}
+
+bool isSelected(Selection *selection, int i)
+{
+    return i >= 0 && i < selection->count && ((selection->bits.at(i/64) >> (i%64)) & 1);
+}
+
+void setSelected(Selection *selection, int i, bool selected)
+{
+    if(selected) {
+        selection->bits.at(i/64) |= (uint64_t)1 << (i%64);
+    } else {
+        selection->bits.at(i/64) &= ~((uint64_t)1 << (i%64));
+    }
+}
+
+void selectRange(Selection *selection, int first, int last, bool selected)
+{
+    //[first, last], filled a word at a time
+    for(int i = first; i <= last; )
+    {
+        int length = std::min(64 - i%64, last - i + 1);
+        setBits(&selection->bits, i, selected ? ~(uint64_t)0 : 0, length);
+        i += length;
+    }
+}
+
+void clearSelection(Selection *selection)
+{
+    std::fill(selection->bits.begin(), selection->bits.end(), 0);
+}
+
+int selectedCount(Selection *selection)
+{
+    int count = 0;
+    for(int w = 0; w < selection->bits.size(); w++)
+    {
+        count += __builtin_popcountll(selection->bits.at(w));
+    }
+    return count;
+}
+
+std::vector<int> selectedEntries(Selection *selection)
+{
+    std::vector<int> entries;
+    for(int w = 0; w < selection->bits.size(); w++)
+    {
+        for(uint64_t word = selection->bits.at(w); word != 0; word &= word - 1)
+        {
+            entries.push_back(w*64 + __builtin_ctzll(word));
+        }
+    }
+    return entries;
+}
+
+uint64_t getBits(const std::vector<uint64_t> &bits, size_t position, int length)
+{
+    //up to 64 bits starting anywhere
+    size_t word = position/64;
+    int offset = position%64;
+    uint64_t value = bits.at(word) >> offset;
+    if(offset != 0 && offset + length > 64)
+    {
+        value |= bits.at(word + 1) << (64 - offset);
+    }
+    return length == 64 ? value : value & (((uint64_t)1 << length) - 1);
+}
+
+void setBits(std::vector<uint64_t> *bits, size_t position, uint64_t value, int length)
+{
+    uint64_t mask = length == 64 ? ~(uint64_t)0 : ((uint64_t)1 << length) - 1;
+    value &= mask;
+    size_t word = position/64;
+    int offset = position%64;
+    bits->at(word) = (bits->at(word) & ~(mask << offset)) | (value << offset);
+    if(offset != 0 && offset + length > 64)
+    {
+        int shift = 64 - offset;
+        bits->at(word + 1) = (bits->at(word + 1) & ~(mask >> shift)) | (value >> shift);
+    }
+}
+
+void copyBits(const std::vector<uint64_t> &source, size_t from, std::vector<uint64_t> *target, size_t to, size_t length)
+{
+    for(size_t done = 0; done < length; done += 64)
+    {
+        int chunk = std::min<size_t>(64, length - done);
+        setBits(target, to + done, getBits(source, from + done, chunk), chunk);
+    }
+}
@@ -0,0 +1,283 @@
+#include "sort.h"
+#include "trace.h"
+#include <algorithm>
+#include <functional>
+#include <string.h>
+
+typedef std::function<bool(int, int)> IndexCompare;
+
+void parallelSort(std::vector<int> *items, IndexCompare less, ThreadPool *pool);
+int compareEntries(EntryTable *table, const std::vector<char> &folded, SortOrder order, int a, int b);
+
+std::vector<int> sortEntryTable(EntryTable *table, SortOrder order, ThreadPool *pool)
+{
+    //returns the permutation applied: row i now holds what was row order[i] [empty if nothing moved]
+    TRACE_SCOPE("sortEntryTable");
+    int count = entryCount(table);
+    if(count < 3)
+    {
+        return std::vector<int>();
+    }
+
+    //case-folded names, at the same offsets as the name arena
+    std::vector<char> folded(table->names.size());
+    foldCase(table->names.data(), table->names.size(), folded.data());
+
+    //group entries by parent directory [entry 0 is the parent entry and stays first]
+    std::vector<std::vector<int> > children(table->directories.size());
+    for(int i = 1; i < count; i++)
+    {
+        children.at(table->parent.at(i)).push_back(i);
+    }
+
+    //big groups are split across the pool, small ones run as one task each
+    IndexCompare less = [table, &folded, order](int a, int b) {
+        return compareEntries(table, folded, order, a, b) < 0;
+    };
+    TaskGroup group;
+    initializeTaskGroup(&group);
+    for(int d = 0; d < children.size(); d++)
+    {
+        std::vector<int> *siblings = &children.at(d);
+        if(siblings->size() >= PARALLEL_SORT_THRESHOLD) {
+            parallelSort(siblings, less, pool);
+        } else if(siblings->size() > 1) {
+            submitTask(pool, &group, [siblings, less]() {
+                std::sort(siblings->begin(), siblings->end(), less);
+            });
+        }
+    }
+    waitForTasks(pool, &group);
+
+    //rebuild the pre-order: each directory row is followed by its sorted children
+    std::vector<int> order_out;
+    order_out.reserve(count);
+    order_out.push_back(0);
+    std::vector<bool> placed(count, false);
+    placed.at(0) = true;
+    std::vector<std::pair<int, int> > stack;  //directory id, next child
+    stack.push_back(std::make_pair(table->parent.at(0), 0));
+    while(!stack.empty())
+    {
+        std::vector<int> *siblings = &children.at(stack.back().first);
+        if(stack.back().second == siblings->size())
+        {
+            stack.pop_back();
+            continue;
+        }
+        int entry = siblings->at(stack.back().second++);
+        order_out.push_back(entry);
+        placed.at(entry) = true;
+        if(table->flags.at(entry) & ENTRY_DIRECTORY)
+        {
+            std::unordered_map<std::string, uint32_t>::iterator dir = table->directory_index.find(entryPath(table, entry));
+            if(dir != table->directory_index.end())
+            {
+                stack.push_back(std::make_pair(dir->second, 0));
+            }
+        }
+    }
+
+    //anything not reachable from the root keeps its relative order at the end
+    for(int i = 0; i < count; i++)
+    {
+        if(!placed.at(i))
+        {
+            order_out.push_back(i);
+        }
+    }
+    permuteEntryRows(table, order_out);
+    return order_out;
+}
+
+bool isPathOrder(SortOrder order)
+{
+    //the order the walker produces, which findEntry() can binary search
+    return order.key == SORT_NAME && !order.descending;
+}
+
+int naturalCompare(const char *first, size_t first_length, const char *second, size_t second_length)
+{
+    //inputs are already case-folded; runs of digits compare by numeric value
+    size_t i = 0;
+    size_t j = 0;
+    while(i < first_length && j < second_length)
+    {
+        unsigned char a = first[i];
+        unsigned char b = second[j];
+        if(a >= '0' && a <= '9' && b >= '0' && b <= '9')
+        {
+            size_t a_start = i;
+            size_t b_start = j;
+            while(a_start < first_length && first[a_start] == '0') a_start++;
+            while(b_start < second_length && second[b_start] == '0') b_start++;
+            size_t a_end = a_start;
+            size_t b_end = b_start;
+            while(a_end < first_length && first[a_end] >= '0' && first[a_end] <= '9') a_end++;
+            while(b_end < second_length && second[b_end] >= '0' && second[b_end] <= '9') b_end++;
+
+            //longer number (without leading zeros) is bigger, otherwise digit by digit
+            if(a_end - a_start != b_end - b_start)
+            {
+                return (a_end - a_start < b_end - b_start) ? -1 : 1;
+            }
+            int digits = memcmp(first + a_start, second + b_start, a_end - a_start);
+            if(digits != 0)
+            {
+                return digits;
+            }
+            i = a_end;
+            j = b_end;
+            continue;
+        }
+        if(a != b)
+        {
+            return (a < b) ? -1 : 1;
+        }
+        i++;
+        j++;
+    }
+    if(i < first_length) return 1;
+    if(j < second_length) return -1;
+    return 0;
+}
+
+bool compareNatural(const std::string &first, const std::string &second)
+{
+    std::string a(first.length(), '\0');
+    std::string b(second.length(), '\0');
+    foldCase(first.data(), first.length(), &a[0]);
+    foldCase(second.data(), second.length(), &b[0]);
+    int cmp = naturalCompare(a.data(), a.length(), b.data(), b.length());
+    if(cmp == 0)
+    {
+        //names differing only in case still get a fixed order
+        return first < second;
+    }
+    return cmp < 0;
+}
+
+bool comparePreOrder(const std::string &first, const std::string &second)
+{
+    //compare path components one by one; a directory comes before anything inside it
+    size_t i = 0;
+    size_t j = 0;
+    while(i < first.length() && j < second.length())
+    {
+        size_t a_end = first.find('/', i);
+        size_t b_end = second.find('/', j);
+        if(a_end == std::string::npos) a_end = first.length();
+        if(b_end == std::string::npos) b_end = second.length();
+
+        std::string a = first.substr(i, a_end - i);
+        std::string b = second.substr(j, b_end - j);
+        if(a != b)
+        {
+            return compareNatural(a, b);
+        }
+        i = a_end + 1;
+        j = b_end + 1;
+    }
+    return first.length() < second.length();
+}
+
+void foldCase(const char *text, size_t length, char *folded)
+{
+    for(size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        folded[i] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+}
+
+int compareEntries(EntryTable *table, const std::vector<char> &folded, SortOrder order, int a, int b)
+{
+    int cmp = 0;
+    switch(order.key)
+    {
+    case SORT_SIZE: {
+        //directories sort by their total once it is known, and as empty before that
+        uint64_t a_size = ((table->flags.at(a) & (ENTRY_DIRECTORY | ENTRY_SIZED)) == ENTRY_DIRECTORY) ? 0 : table->size.at(a);
+        uint64_t b_size = ((table->flags.at(b) & (ENTRY_DIRECTORY | ENTRY_SIZED)) == ENTRY_DIRECTORY) ? 0 : table->size.at(b);
+        cmp = (a_size < b_size) ? -1 : (a_size > b_size);
+        break;
+    }
+    case SORT_PERMISSIONS:
+        cmp = (int)(table->mode.at(a) & 0777) - (int)(table->mode.at(b) & 0777);
+        break;
+    case SORT_TYPE:
+        cmp = (int)table->icon_type.at(a) - (int)table->icon_type.at(b);
+        break;
+    case SORT_MTIME:
+        cmp = (table->mtime.at(a) < table->mtime.at(b)) ? -1 : (table->mtime.at(a) > table->mtime.at(b));
+        break;
+    default:
+        break;
+    }
+
+    //ties (and SORT_NAME) fall back to the name, then to the exact bytes
+    if(cmp == 0)
+    {
+        const char *a_name = folded.data() + table->name_offset.at(a);
+        const char *b_name = folded.data() + table->name_offset.at(b);
+        cmp = naturalCompare(a_name, table->name_length.at(a), b_name, table->name_length.at(b));
+    }
+    if(cmp == 0)
+    {
+        std::string a_raw = entryName(table, a);
+        std::string b_raw = entryName(table, b);
+        cmp = a_raw.compare(b_raw);
+    }
+    if(cmp == 0)
+    {
+        cmp = a - b;
+    }
+    return order.descending ? -cmp : cmp;
+}
+
+void parallelSort(std::vector<int> *items, IndexCompare less, ThreadPool *pool)
+{
+    //sort equal chunks concurrently, then merge neighbours pairwise until one run is left
+    int chunks = std::max<int>(1, pool->threads.size());
+    size_t length = items->size();
+    std::vector<size_t> bounds;
+    for(int c = 0; c <= chunks; c++)
+    {
+        bounds.push_back(length*c/chunks);
+    }
+
+    TaskGroup group;
+    initializeTaskGroup(&group);
+    for(int c = 0; c < chunks; c++)
+    {
+        size_t begin = bounds.at(c);
+        size_t end = bounds.at(c + 1);
+        submitTask(pool, &group, [items, begin, end, less]() {
+            std::sort(items->begin() + begin, items->begin() + end, less);
+        });
+    }
+    waitForTasks(pool, &group);
+
+    while(bounds.size() > 2)
+    {
+        std::vector<size_t> merged;
+        for(int c = 0; c + 2 < bounds.size(); c += 2)
+        {
+            size_t begin = bounds.at(c);
+            size_t middle = bounds.at(c + 1);
+            size_t end = bounds.at(c + 2);
+            submitTask(pool, &group, [items, begin, middle, end, less]() {
+                std::inplace_merge(items->begin() + begin, items->begin() + middle, items->begin() + end, less);
+            });
+            merged.push_back(begin);
+        }
+        if(bounds.size() % 2 == 0)
+        {
+            //odd run out is carried over unmerged
+            merged.push_back(bounds.at(bounds.size() - 2));
+        }
+        merged.push_back(length);
+        waitForTasks(pool, &group);
+        bounds = merged;
+    }
+}
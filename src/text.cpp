@@ -0,0 +1,216 @@
+#include "text.h"
+#include "trace.h"
+#include <algorithm>
+
+Glyph* getGlyph(GlyphAtlas *atlas, Uint32 code_point);
+bool rasterizeGlyph(GlyphAtlas *atlas, Uint32 code_point, Glyph *glyph);
+
+bool initializeGlyphAtlas(SDL_Renderer *renderer, TTF_Font *font, GlyphAtlas *atlas)
+{
+    atlas->font = font;
+    atlas->renderer = renderer;
+    atlas->line_height = TTF_FontHeight(font);
+    atlas->pen_x = 0;
+    atlas->pen_y = 0;
+    atlas->shelf_height = 0;
+    for(int i = 0; i < 128; i++)
+    {
+        atlas->ascii_loaded[i] = false;
+    }
+    atlas->extended.clear();
+
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_SIZE, ATLAS_SIZE);
+    if(atlas->texture == NULL)
+    {
+        fprintf(stderr, "Error: could not create glyph atlas: %s\n", SDL_GetError());
+        return false;
+    }
+    countTexture(ATLAS_SIZE, ATLAS_SIZE, 1);
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+    //printable ascii covers nearly every file name, so rasterize it up front
+    for(Uint32 c = ' '; c < 127; c++)
+    {
+        getGlyph(atlas, c);
+    }
+    return true;
+}
+
+void cleanGlyphAtlas(GlyphAtlas *atlas)
+{
+    if(atlas->texture != NULL)
+    {
+        countTexture(ATLAS_SIZE, ATLAS_SIZE, -1);
+    }
+    SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+    atlas->extended.clear();
+    atlas->vertices.clear();
+    atlas->indices.clear();
+}
+
+int measureText(GlyphAtlas *atlas, const char *text)
+{
+    int width = 0;
+    while(*text != '\0')
+    {
+        Glyph *glyph = getGlyph(atlas, nextCodePoint(&text));
+        width += glyph->advance;
+    }
+    return width;
+}
+
+int queueText(GlyphAtlas *atlas, const char *text, int x, int y, SDL_Color color)
+{
+    int pen = x;
+    while(*text != '\0')
+    {
+        Glyph *glyph = getGlyph(atlas, nextCodePoint(&text));
+        if(glyph->source.w > 0)
+        {
+            //two triangles per glyph
+            float left = pen;
+            float top = y;
+            float right = pen + glyph->source.w;
+            float bottom = y + glyph->source.h;
+            float u0 = (float)glyph->source.x / ATLAS_SIZE;
+            float v0 = (float)glyph->source.y / ATLAS_SIZE;
+            float u1 = (float)(glyph->source.x + glyph->source.w) / ATLAS_SIZE;
+            float v1 = (float)(glyph->source.y + glyph->source.h) / ATLAS_SIZE;
+
+            int base = atlas->vertices.size();
+            atlas->vertices.push_back({{left, top}, color, {u0, v0}});
+            atlas->vertices.push_back({{right, top}, color, {u1, v0}});
+            atlas->vertices.push_back({{right, bottom}, color, {u1, v1}});
+            atlas->vertices.push_back({{left, bottom}, color, {u0, v1}});
+            int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+            atlas->indices.insert(atlas->indices.end(), quad, quad + 6);
+        }
+        pen += glyph->advance;
+    }
+    return pen - x;
+}
+
+void flushText(GlyphAtlas *atlas)
+{
+    TRACE_SCOPE("flushText");
+    if(!atlas->indices.empty())
+    {
+        SDL_RenderGeometry(atlas->renderer, atlas->texture, atlas->vertices.data(), atlas->vertices.size(),
+                           atlas->indices.data(), atlas->indices.size());
+    }
+    atlas->vertices.clear();
+    atlas->indices.clear();
+}
+
+Uint32 nextCodePoint(const char **text)
+{
+    const unsigned char *s = (const unsigned char *)*text;
+    Uint32 c = s[0];
+    int length = 1;
+
+    //lead byte gives the sequence length, malformed input becomes U+FFFD
+    if(c < 0x80) {
+        length = 1;
+    } else if((c & 0xE0) == 0xC0) {
+        length = 2;
+        c &= 0x1F;
+    } else if((c & 0xF0) == 0xE0) {
+        length = 3;
+        c &= 0x0F;
+    } else if((c & 0xF8) == 0xF0) {
+        length = 4;
+        c &= 0x07;
+    } else {
+        *text += 1;
+        return 0xFFFD;
+    }
+
+    for(int i = 1; i < length; i++)
+    {
+        if((s[i] & 0xC0) != 0x80)
+        {
+            *text += i;
+            return 0xFFFD;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+    *text += length;
+    return c;
+}
+
+Glyph* getGlyph(GlyphAtlas *atlas, Uint32 code_point)
+{
+    if(code_point < 128)
+    {
+        if(!atlas->ascii_loaded[code_point])
+        {
+            rasterizeGlyph(atlas, code_point, &(atlas->ascii[code_point]));
+            atlas->ascii_loaded[code_point] = true;
+        }
+        return &(atlas->ascii[code_point]);
+    }
+
+    std::unordered_map<Uint32, Glyph>::iterator found = atlas->extended.find(code_point);
+    if(found != atlas->extended.end())
+    {
+        return &(found->second);
+    }
+    Glyph glyph = {};
+    if(!TTF_GlyphIsProvided32(atlas->font, code_point) || !rasterizeGlyph(atlas, code_point, &glyph))
+    {
+        //fall back to the replacement character, or to '?' if the font lacks that too
+        glyph = (code_point != 0xFFFD) ? *getGlyph(atlas, 0xFFFD) : *getGlyph(atlas, '?');
+    }
+    return &(atlas->extended[code_point] = glyph);
+}
+
+bool rasterizeGlyph(GlyphAtlas *atlas, Uint32 code_point, Glyph *glyph)
+{
+    glyph->source = {0, 0, 0, 0};
+    glyph->advance = 0;
+
+    int min_x, max_x, min_y, max_y;
+    if(TTF_GlyphMetrics32(atlas->font, code_point, &min_x, &max_x, &min_y, &max_y, &(glyph->advance)) != 0)
+    {
+        return false;
+    }
+
+    TRACE_SCOPE("rasterizeGlyph");
+
+    //rendered white so the vertex color alone decides the text color
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *rendered = TTF_RenderGlyph32_Blended(atlas->font, code_point, white);
+    if(rendered == NULL)
+    {
+        //whitespace has an advance but no pixels
+        return true;
+    }
+    SDL_Surface *surf = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(rendered);
+    if(surf == NULL)
+    {
+        return false;
+    }
+
+    //start a new shelf when this row of the atlas is full
+    if(atlas->pen_x + surf->w > ATLAS_SIZE)
+    {
+        atlas->pen_x = 0;
+        atlas->pen_y += atlas->shelf_height + 1;
+        atlas->shelf_height = 0;
+    }
+    if(atlas->pen_y + surf->h > ATLAS_SIZE || surf->w > ATLAS_SIZE)
+    {
+        SDL_FreeSurface(surf);
+        return false;
+    }
+
+    glyph->source = {atlas->pen_x, atlas->pen_y, surf->w, surf->h};
+    SDL_UpdateTexture(atlas->texture, &(glyph->source), surf->pixels, surf->pitch);
+    atlas->pen_x += surf->w + 1;
+    atlas->shelf_height = std::max(atlas->shelf_height, surf->h);
+
+    SDL_FreeSurface(surf);
+    return true;
+}
@@ -0,0 +1,168 @@
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+
+//index of the pool worker running on this thread, -1 for other threads
+static thread_local int worker_index = -1;
+static thread_local ThreadPool *worker_pool = NULL;
+
+bool runOneTask(ThreadPool *pool, int self);
+void workerLoop(ThreadPool *pool, int self);
+
+ThreadPool* createThreadPool(int threads)
+{
+    if(threads < 1)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ThreadPool *pool = new ThreadPool();
+    pool->queued = 0;
+    pool->next_queue = 0;
+    pool->stopping = false;
+    for(int i = 0; i < threads; i++)
+    {
+        pool->queues.push_back(new WorkerQueue());
+    }
+    for(int i = 0; i < threads; i++)
+    {
+        pool->threads.push_back(std::thread(workerLoop, pool, i));
+    }
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool *pool)
+{
+    {
+        std::lock_guard<std::mutex> guard(pool->sleep_lock);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+    for(int i = 0; i < pool->threads.size(); i++)
+    {
+        pool->threads.at(i).join();
+    }
+    for(int i = 0; i < pool->queues.size(); i++)
+    {
+        delete pool->queues.at(i);
+    }
+    delete pool;
+}
+
+void initializeTaskGroup(TaskGroup *group)
+{
+    group->pending = 0;
+    group->cancelled = false;
+}
+
+void submitTask(ThreadPool *pool, TaskGroup *group, std::function<void()> run)
+{
+    group->pending++;
+
+    //workers keep their own spawns local, other threads spread work round robin
+    int target;
+    if(worker_pool == pool) {
+        target = worker_index;
+    } else {
+        target = pool->next_queue++ % pool->queues.size();
+    }
+    WorkerQueue *queue = pool->queues.at(target);
+    {
+        std::lock_guard<std::mutex> guard(queue->lock);
+        queue->tasks.push_back({run, group});
+    }
+    pool->queued++;
+
+    //taking the lock orders this wake-up after a worker's check of queued
+    {
+        std::lock_guard<std::mutex> guard(pool->sleep_lock);
+    }
+    pool->wake.notify_one();
+}
+
+void waitForTasks(ThreadPool *pool, TaskGroup *group)
+{
+    int self = (worker_pool == pool) ? worker_index : -1;
+    while(group->pending > 0)
+    {
+        //a waiting worker helps instead of blocking the pool
+        if(self >= 0 && runOneTask(pool, self))
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(pool->sleep_lock);
+        pool->finished.wait_for(lock, std::chrono::milliseconds(self >= 0 ? 1 : 50), [group]() {
+            return group->pending == 0;
+        });
+    }
+}
+
+bool runOneTask(ThreadPool *pool, int self)
+{
+    Task task;
+    bool found = false;
+
+    //own queue first (newest work, still warm in cache)
+    WorkerQueue *own = pool->queues.at(self);
+    {
+        std::lock_guard<std::mutex> guard(own->lock);
+        if(!own->tasks.empty())
+        {
+            task = own->tasks.back();
+            own->tasks.pop_back();
+            found = true;
+        }
+    }
+
+    //then steal the oldest work of another worker
+    int count = pool->queues.size();
+    for(int i = 1; i < count && !found; i++)
+    {
+        WorkerQueue *victim = pool->queues.at((self + i) % count);
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if(!victim->tasks.empty())
+        {
+            task = victim->tasks.front();
+            victim->tasks.pop_front();
+            found = true;
+        }
+    }
+    if(!found)
+    {
+        return false;
+    }
+
+    pool->queued--;
+    if(!task.group->cancelled)
+    {
+        task.run();
+    }
+    if(--task.group->pending == 0)
+    {
+        std::lock_guard<std::mutex> guard(pool->sleep_lock);
+        pool->finished.notify_all();
+    }
+    return true;
+}
+
+void workerLoop(ThreadPool *pool, int self)
+{
+    worker_index = self;
+    worker_pool = pool;
+    traceThreadName("worker " + std::to_string(self));
+    while(true)
+    {
+        if(runOneTask(pool, self))
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(pool->sleep_lock);
+        pool->wake.wait(lock, [pool]() {
+            return pool->stopping || pool->queued > 0;
+        });
+        if(pool->stopping)
+        {
+            return;
+        }
+    }
+}
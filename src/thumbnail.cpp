@@ -0,0 +1,302 @@
+#include "thumbnail.h"
+#include "trace.h"
+#include <SDL_image.h>
+#include <algorithm>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+
+void decodeThumbnail(std::shared_ptr<ThumbnailQueue> queue, std::string path, int64_t mtime, uint64_t size);
+SDL_Surface* scaleThumbnail(SDL_Surface *image);
+std::string thumbnailFile(ThumbnailQueue *queue, const std::string &path, int64_t mtime, uint64_t size);
+SDL_Surface* readThumbnail(const std::string &filename);
+void writeThumbnail(const std::string &filename, SDL_Surface *surface);
+void evictThumbnails(ThumbnailCache *cache);
+
+std::string defaultThumbnailDir()
+{
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    std::string base = (cache_home != NULL && cache_home[0] != '\0') ? cache_home : std::string(getenv("HOME")) + "/.cache";
+    return base + "/fileexplorer/thumbnails";
+}
+
+void initializeThumbnails(ThumbnailCache *cache, size_t budget, const std::string &disk_dir, Uint32 event_type)
+{
+    cache->decoders = createThreadPool(THUMB_DECODERS);
+    initializeTaskGroup(&cache->group);
+    cache->queue = std::make_shared<ThumbnailQueue>();
+    cache->queue->frame = 0;
+    cache->queue->notified = false;
+    cache->queue->event_type = event_type;
+    cache->queue->disk_dir = disk_dir;
+    cache->budget = budget;
+    cache->bytes = 0;
+
+    std::error_code error;
+    if(!disk_dir.empty() && !std::filesystem::create_directories(disk_dir, error) && error)
+    {
+        fprintf(stderr, "Error: thumbnail cache '%s' could not be created: %s\n", disk_dir.c_str(), error.message().c_str());
+        cache->queue->disk_dir.clear();
+    }
+}
+
+void cleanThumbnails(ThumbnailCache *cache)
+{
+    //queued decodes are skipped; a running one finishes into the queue, which is freed below
+    cache->group.cancelled = true;
+    destroyThreadPool(cache->decoders);
+    cache->decoders = NULL;
+
+    for(int i = 0; i < cache->queue->decoded.size(); i++)
+    {
+        SDL_FreeSurface(cache->queue->decoded.at(i).surface);
+    }
+    cache->queue->decoded.clear();
+    for(std::unordered_map<std::string, Thumbnail>::iterator it = cache->thumbnails.begin(); it != cache->thumbnails.end(); it++)
+    {
+        if(it->second.texture != NULL)
+        {
+            countTexture(it->second.width, it->second.height, -1);
+            SDL_DestroyTexture(it->second.texture);
+        }
+    }
+    cache->thumbnails.clear();
+    cache->lru.clear();
+    cache->bytes = 0;
+}
+
+void beginThumbnailFrame(ThumbnailCache *cache)
+{
+    cache->queue->frame++;
+}
+
+SDL_Texture* findThumbnail(ThumbnailCache *cache, const std::string &path, int64_t mtime, uint64_t size, int *width, int *height)
+{
+    //never waits: a missing thumbnail is requested and the row keeps its icon until it arrives
+    std::unordered_map<std::string, Thumbnail>::iterator found = cache->thumbnails.find(path);
+    if(found != cache->thumbnails.end() && found->second.mtime == mtime && found->second.size == size)
+    {
+        cache->lru.splice(cache->lru.begin(), cache->lru, found->second.lru);
+        *width = found->second.width;
+        *height = found->second.height;
+        return found->second.texture;
+    }
+
+    ThumbnailQueue *queue = cache->queue.get();
+    std::lock_guard<std::mutex> guard(queue->lock);
+    std::unordered_map<std::string, unsigned>::iterator pending = queue->pending.find(path);
+    if(pending != queue->pending.end()) {
+        pending->second = queue->frame;
+    } else {
+        queue->pending[path] = queue->frame;
+        std::shared_ptr<ThumbnailQueue> shared = cache->queue;
+        submitTask(cache->decoders, &cache->group, [shared, path, mtime, size]() {
+            decodeThumbnail(shared, path, mtime, size);
+        });
+    }
+    return NULL;
+}
+
+bool uploadThumbnails(SDL_Renderer *renderer, ThumbnailCache *cache)
+{
+    //runs on the render thread, the only one allowed to create textures
+    ThumbnailQueue *queue = cache->queue.get();
+    std::vector<DecodedThumbnail> decoded;
+    bool more;
+    {
+        std::lock_guard<std::mutex> guard(queue->lock);
+        int count = std::min<int>(THUMB_UPLOADS_PER_FRAME, queue->decoded.size());
+        decoded.assign(queue->decoded.begin(), queue->decoded.begin() + count);
+        queue->decoded.erase(queue->decoded.begin(), queue->decoded.begin() + count);
+        more = !queue->decoded.empty();
+        queue->notified = more;
+    }
+    if(more)
+    {
+        //the rest go up next frame
+        SDL_Event event;
+        SDL_memset(&event, 0, sizeof(event));
+        event.type = queue->event_type;
+        SDL_PushEvent(&event);
+    }
+
+    TRACE_SCOPE("uploadThumbnails");
+    for(int i = 0; i < decoded.size(); i++)
+    {
+        DecodedThumbnail *item = &decoded.at(i);
+        std::unordered_map<std::string, Thumbnail>::iterator old = cache->thumbnails.find(item->path);
+        if(old != cache->thumbnails.end())
+        {
+            if(old->second.texture != NULL)
+            {
+                countTexture(old->second.width, old->second.height, -1);
+                SDL_DestroyTexture(old->second.texture);
+            }
+            cache->bytes -= old->second.bytes;
+            cache->lru.erase(old->second.lru);
+            cache->thumbnails.erase(old);
+        }
+
+        Thumbnail thumbnail = {NULL, 0, 0, item->mtime, item->size, 0, cache->lru.end()};
+        if(item->surface != NULL)
+        {
+            thumbnail.texture = SDL_CreateTextureFromSurface(renderer, item->surface);
+            thumbnail.width = item->surface->w;
+            thumbnail.height = item->surface->h;
+            SDL_FreeSurface(item->surface);
+        }
+        if(thumbnail.texture != NULL) {
+            thumbnail.bytes = (size_t)thumbnail.width*thumbnail.height*4;
+            countTexture(thumbnail.width, thumbnail.height, 1);
+        } else {
+            thumbnail.bytes = THUMB_FAILURE_BYTES;
+        }
+        cache->lru.push_front(item->path);
+        thumbnail.lru = cache->lru.begin();
+        cache->bytes += thumbnail.bytes;
+        cache->thumbnails[item->path] = thumbnail;
+    }
+    evictThumbnails(cache);
+    return !decoded.empty();
+}
+
+void evictThumbnails(ThumbnailCache *cache)
+{
+    //least recently drawn go first, failures included [a failure evicted is just tried again if it comes back]
+    while(cache->bytes > cache->budget && !cache->lru.empty())
+    {
+        std::unordered_map<std::string, Thumbnail>::iterator oldest = cache->thumbnails.find(cache->lru.back());
+        if(oldest->second.texture != NULL)
+        {
+            countTexture(oldest->second.width, oldest->second.height, -1);
+            SDL_DestroyTexture(oldest->second.texture);
+        }
+        cache->bytes -= oldest->second.bytes;
+        cache->thumbnails.erase(oldest);
+        cache->lru.pop_back();
+    }
+}
+
+void decodeThumbnail(std::shared_ptr<ThumbnailQueue> queue, std::string path, int64_t mtime, uint64_t size)
+{
+    //skipped if the row left the view (plus a frame of slack) before a decoder got to it
+    {
+        std::lock_guard<std::mutex> guard(queue->lock);
+        if(queue->frame - queue->pending[path] > 1)
+        {
+            queue->pending.erase(path);
+            return;
+        }
+    }
+
+    TRACE_SCOPE("decodeThumbnail");
+    std::string filename = queue->disk_dir.empty() ? "" : thumbnailFile(queue.get(), path, mtime, size);
+    SDL_Surface *surface = filename.empty() ? NULL : readThumbnail(filename);
+    if(surface == NULL)
+    {
+        SDL_Surface *image = IMG_Load(path.c_str());
+        if(image != NULL)
+        {
+            surface = scaleThumbnail(image);
+            SDL_FreeSurface(image);
+        }
+        if(surface != NULL && !filename.empty())
+        {
+            writeThumbnail(filename, surface);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->pending.erase(path);
+    queue->decoded.push_back({path, mtime, size, surface});
+    if(!queue->notified.exchange(true))
+    {
+        SDL_Event event;
+        SDL_memset(&event, 0, sizeof(event));
+        event.type = queue->event_type;
+        SDL_PushEvent(&event);
+    }
+}
+
+SDL_Surface* scaleThumbnail(SDL_Surface *image)
+{
+    //fit within THUMB_SIZE, keeping the aspect ratio; small images stay as they are
+    SDL_Surface *source = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+    if(source == NULL)
+    {
+        return NULL;
+    }
+    int longest = std::max(source->w, source->h);
+    if(longest <= THUMB_SIZE)
+    {
+        return source;
+    }
+    int width = std::max(1, source->w*THUMB_SIZE/longest);
+    int height = std::max(1, source->h*THUMB_SIZE/longest);
+    SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if(scaled != NULL)
+    {
+        SDL_SetSurfaceBlendMode(source, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(source, NULL, scaled, NULL);
+    }
+    SDL_FreeSurface(source);
+    return scaled;
+}
+
+std::string thumbnailFile(ThumbnailQueue *queue, const std::string &path, int64_t mtime, uint64_t size)
+{
+    //a changed file gets a new name; stale files are simply never read again
+    char name[80];
+    snprintf(name, sizeof(name), "/%016zx-%llx-%llx.thumb", std::hash<std::string>()(path), (unsigned long long)mtime, (unsigned long long)size);
+    return queue->disk_dir + name;
+}
+
+SDL_Surface* readThumbnail(const std::string &filename)
+{
+    //magic, width, height, then ARGB8888 rows
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(file == NULL)
+    {
+        return NULL;
+    }
+    uint32_t header[3];
+    SDL_Surface *surface = NULL;
+    if(fread(header, sizeof(header), 1, file) == 1 && header[0] == THUMB_MAGIC &&
+       header[1] > 0 && header[1] <= THUMB_SIZE && header[2] > 0 && header[2] <= THUMB_SIZE)
+    {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, header[1], header[2], 32, SDL_PIXELFORMAT_ARGB8888);
+        for(int y = 0; surface != NULL && y < surface->h; y++)
+        {
+            if(fread((char*)surface->pixels + y*surface->pitch, surface->w*4, 1, file) != 1)
+            {
+                SDL_FreeSurface(surface);
+                surface = NULL;
+            }
+        }
+    }
+    fclose(file);
+    return surface;
+}
+
+void writeThumbnail(const std::string &filename, SDL_Surface *surface)
+{
+    //written under a temporary name so a reader never sees half a file
+    std::string temporary = filename + ".tmp." + std::to_string(getpid());
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if(file == NULL)
+    {
+        return;
+    }
+    uint32_t header[3] = {THUMB_MAGIC, (uint32_t)surface->w, (uint32_t)surface->h};
+    bool written = fwrite(header, sizeof(header), 1, file) == 1;
+    for(int y = 0; written && y < surface->h; y++)
+    {
+        written = fwrite((char*)surface->pixels + y*surface->pitch, surface->w*4, 1, file) == 1;
+    }
+    written = (fclose(file) == 0) && written;
+    if(!written || rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+    }
+}
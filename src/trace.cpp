@@ -0,0 +1,183 @@
+#include "trace.h"
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+
+std::atomic<bool> trace_enabled(false);
+TextureStats texture_stats = {{0}, {0}};
+
+//every ring ever created; rings live as long as the process so a thread may exit at any time
+static std::mutex ring_lock;
+static std::vector<TraceRing*> rings;
+static thread_local TraceRing *thread_ring = NULL;
+static thread_local std::string thread_name;
+
+TraceRing* getTraceRing();
+void writeJsonString(std::ofstream &out, const std::string &text);
+
+void startTrace()
+{
+    trace_enabled = true;
+}
+
+void stopTrace()
+{
+    trace_enabled = false;
+}
+
+uint64_t traceClock()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000000 + now.tv_nsec;
+}
+
+void traceThreadName(const std::string &name)
+{
+    thread_name = name;
+    if(thread_ring != NULL)
+    {
+        std::lock_guard<std::mutex> guard(ring_lock);
+        thread_ring->thread_name = name;
+    }
+}
+
+TraceRing* getTraceRing()
+{
+    //first event on this thread: the ring is allocated once and registered for export
+    if(thread_ring == NULL)
+    {
+        TraceRing *ring = new TraceRing();
+        ring->head = 0;
+        ring->thread_name = thread_name;
+        std::lock_guard<std::mutex> guard(ring_lock);
+        ring->thread_id = rings.size() + 1;
+        rings.push_back(ring);
+        thread_ring = ring;
+    }
+    return thread_ring;
+}
+
+void traceComplete(const char *name, uint64_t start, uint64_t end, int64_t value)
+{
+    TraceRing *ring = getTraceRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head & (TRACE_RING_SIZE - 1)] = {name, start, end - start, value, TRACE_COMPLETE};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void traceCounter(const char *name, int64_t value)
+{
+    if(!trace_enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    TraceRing *ring = getTraceRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head & (TRACE_RING_SIZE - 1)] = {name, traceClock(), 0, value, TRACE_COUNTER};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void countTexture(int width, int height, int sign)
+{
+    //every texture here is 32-bit
+    texture_stats.count += sign;
+    texture_stats.bytes += (int64_t)sign*width*height*4;
+    traceCounter("texture bytes", texture_stats.bytes);
+}
+
+bool writeTrace(const std::string &path)
+{
+    std::ofstream out(path);
+    if(!out)
+    {
+        fprintf(stderr, "Error: trace file '%s' could not be written\n", path.c_str());
+        return false;
+    }
+
+    std::vector<TraceRing*> snapshot;
+    {
+        std::lock_guard<std::mutex> guard(ring_lock);
+        snapshot = rings;
+    }
+    int pid = getpid();
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for(int i = 0; i < snapshot.size(); i++)
+    {
+        TraceRing *ring = snapshot.at(i);
+        std::string name;
+        {
+            std::lock_guard<std::mutex> guard(ring_lock);
+            name = ring->thread_name;
+        }
+        if(!name.empty())
+        {
+            out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << ring->thread_id << ",\"args\":{\"name\":";
+            writeJsonString(out, name);
+            out << "}}";
+            first = false;
+        }
+
+        //the owner keeps recording; copy what is there, then drop whatever it may have overwritten meanwhile
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        std::vector<TraceEvent> events(head - begin);
+        for(uint64_t e = begin; e < head; e++)
+        {
+            events.at(e - begin) = ring->events[e & (TRACE_RING_SIZE - 1)];
+        }
+        uint64_t after = ring->head.load(std::memory_order_acquire);
+        uint64_t valid = after > TRACE_RING_SIZE ? after - TRACE_RING_SIZE : 0;
+
+        for(uint64_t e = std::max(begin, valid); e < head; e++)
+        {
+            TraceEvent *event = &events.at(e - begin);
+            out << (first ? "" : ",\n") << "{\"ph\":\"" << event->phase << "\",\"name\":";
+            writeJsonString(out, event->name);
+            out << ",\"pid\":" << pid << ",\"tid\":" << ring->thread_id << ",\"ts\":" << event->start/1000 << "." << (event->start%1000)/100;
+            if(event->phase == TRACE_COMPLETE) {
+                out << ",\"dur\":" << event->duration/1000 << "." << (event->duration%1000)/100;
+                if(event->value != 0)
+                {
+                    out << ",\"args\":{\"value\":" << event->value << "}";
+                }
+            } else {
+                out << ",\"args\":{\"value\":" << event->value << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    if(!out)
+    {
+        fprintf(stderr, "Error: trace file '%s' could not be written\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void writeJsonString(std::ofstream &out, const std::string &text)
+{
+    out << '"';
+    for(int i = 0; i < text.length(); i++)
+    {
+        unsigned char c = text.at(i);
+        if(c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if(c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
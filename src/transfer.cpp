@@ -0,0 +1,447 @@
+#include "transfer.h"
+#include "scan.h"
+#include "entries.h"
+#include "trace.h"
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <set>
+#include <string.h>
+
+void startJob(TransferQueue *queue, std::shared_ptr<TransferJob> job);
+void planJob(std::shared_ptr<TransferJob> job);
+void copyEntry(std::shared_ptr<TransferJob> job, const std::string &source, const std::string &target);
+void copyFile(TransferJob *job, const std::string &source, const std::string &target, mode_t mode);
+void removeEntry(TransferJob *job, const std::string &path);
+void releaseJob(TransferJob *job);
+void notifyProgress(TransferJob *job, bool force);
+void transferError(TransferJob *job, const char *action, const std::string &path, int error);
+std::string uniqueTarget(const std::string &directory, const std::string &name, std::set<std::string> *taken);
+std::string baseName(const std::string &path);
+
+void initializeTransfers(TransferQueue *queue, Uint32 event_type)
+{
+    queue->pool = createThreadPool(TRANSFER_THREADS);
+    queue->event_type = event_type;
+}
+
+void cleanTransfers(TransferQueue *queue)
+{
+    //the running job stops at its next chunk; queued ones never start
+    cancelTransfers(queue);
+    if(!queue->jobs.empty())
+    {
+        waitForTasks(queue->pool, &queue->jobs.front()->group);
+    }
+    queue->jobs.clear();
+    destroyThreadPool(queue->pool);
+}
+
+void queueTransfer(TransferQueue *queue, int operation, const std::vector<std::string> &sources, const std::string &destination)
+{
+    std::shared_ptr<TransferJob> job = std::make_shared<TransferJob>();
+    job->operation = operation;
+    job->sources = sources;
+    job->destination = destination;
+    job->pool = queue->pool;
+    job->event_type = queue->event_type;
+    job->bytes_total = 0;
+    job->bytes_done = 0;
+    job->files_total = 0;
+    job->files_done = 0;
+    job->errors = 0;
+    job->cancelled = false;
+    job->finished = false;
+    job->last_notify = 0;
+    job->outstanding = 0;
+    initializeTaskGroup(&job->group);
+    queue->jobs.push_back(job);
+    if(queue->jobs.size() == 1)
+    {
+        startJob(queue, job);
+    }
+}
+
+void cancelTransfers(TransferQueue *queue)
+{
+    //tasks are not dropped from the pool, since each one has to count itself out of the job
+    for(int i = 0; i < queue->jobs.size(); i++)
+    {
+        queue->jobs.at(i)->cancelled = true;
+    }
+    if(queue->jobs.size() > 1)
+    {
+        queue->jobs.erase(queue->jobs.begin() + 1, queue->jobs.end());
+    }
+}
+
+bool updateTransfers(TransferQueue *queue, SDL_Event *event)
+{
+    //progress or a finished job: retire it and start the next one
+    if(event->type != queue->event_type)
+    {
+        return false;
+    }
+    while(!queue->jobs.empty() && queue->jobs.front()->finished)
+    {
+        TransferJob *job = queue->jobs.front().get();
+        if(job->errors > 0)
+        {
+            fprintf(stderr, "Error: %d entries could not be %s\n", (int)job->errors,
+                    job->operation == TRANSFER_COPY ? "copied" : job->operation == TRANSFER_MOVE ? "moved" : "deleted");
+        }
+        queue->jobs.pop_front();
+        if(!queue->jobs.empty())
+        {
+            startJob(queue, queue->jobs.front());
+        }
+    }
+    return true;
+}
+
+std::string transferStatus(TransferQueue *queue)
+{
+    //one line for the running job, empty when there is none
+    if(queue->jobs.empty())
+    {
+        return "";
+    }
+    TransferJob *job = queue->jobs.front().get();
+    char line[256];
+    if(job->operation == TRANSFER_DELETE)
+    {
+        snprintf(line, sizeof(line), "Deleting, %d removed", (int)job->files_done);
+    }
+    else
+    {
+        double seconds = (double)(SDL_GetPerformanceCounter() - job->started)/SDL_GetPerformanceFrequency();
+        uint64_t rate = (seconds > 0) ? (uint64_t)(job->bytes_done/seconds) : 0;
+        snprintf(line, sizeof(line), "%s %d/%d files, %s of %s, %s/s", job->operation == TRANSFER_COPY ? "Copying" : "Moving",
+                 (int)job->files_done, (int)job->files_total, formatSize(job->bytes_done).c_str(),
+                 formatSize(job->bytes_total).c_str(), formatSize(rate).c_str());
+    }
+    std::string status = line;
+    if(queue->jobs.size() > 1)
+    {
+        status += ", " + std::to_string(queue->jobs.size() - 1) + " more queued";
+    }
+    return status + (job->cancelled ? ", cancelling" : " [Esc cancels]");
+}
+
+void startJob(TransferQueue *queue, std::shared_ptr<TransferJob> job)
+{
+    job->started = SDL_GetPerformanceCounter();
+    job->outstanding = 1;
+    submitTask(queue->pool, &job->group, [job]() {
+        planJob(job);
+    });
+}
+
+void planJob(std::shared_ptr<TransferJob> job)
+{
+    TRACE_SCOPE("planTransfer");
+    //targets picked so far [files are created later by their own tasks, so the disk does not know yet]
+    std::set<std::string> taken;
+    for(int i = 0; i < job->sources.size() && !job->cancelled; i++)
+    {
+        const std::string &source = job->sources.at(i);
+        if(job->operation == TRANSFER_DELETE)
+        {
+            removeEntry(job.get(), source);
+            continue;
+        }
+
+        //a directory cannot go inside itself
+        const std::string &destination = job->destination;
+        if(destination == source || destination.compare(0, source.length() + 1, source + "/") == 0)
+        {
+            transferError(job.get(), "copy into itself", source, EINVAL);
+            continue;
+        }
+        std::string name = baseName(source);
+        if(job->operation == TRANSFER_MOVE && source == destination + "/" + name)
+        {
+            continue;
+        }
+        std::string target = uniqueTarget(destination, name, &taken);
+        if(job->operation == TRANSFER_MOVE)
+        {
+            //same filesystem: one rename, whatever the size
+            if(rename(source.c_str(), target.c_str()) == 0)
+            {
+                job->files_done++;
+                job->files_total++;
+                notifyProgress(job.get(), false);
+                continue;
+            }
+            if(errno != EXDEV)
+            {
+                transferError(job.get(), "move", source, errno);
+                continue;
+            }
+            std::lock_guard<std::mutex> guard(job->lock);
+            job->moved.push_back(source);
+        }
+        copyEntry(job, source, target);
+    }
+    releaseJob(job.get());
+}
+
+void copyEntry(std::shared_ptr<TransferJob> job, const std::string &source, const std::string &target)
+{
+    if(job->cancelled)
+    {
+        return;
+    }
+    struct stat info;
+    if(lstat(source.c_str(), &info) != 0)
+    {
+        transferError(job.get(), "read", source, errno);
+        return;
+    }
+
+    if(S_ISDIR(info.st_mode))
+    {
+        //owner-writable while its contents are copied in; its own permissions are applied at the end
+        if(mkdir(target.c_str(), 0700) != 0)
+        {
+            transferError(job.get(), "create", target, errno);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(job->lock);
+            job->directories.push_back(std::make_pair(target, info.st_mode & 0777));
+        }
+        std::vector<EntryMeta> children;
+        ScanStats stats = {0, 0, 0};
+        int error = scanDirectory(source, SCAN_TYPE, &children, &stats);
+        if(error != 0)
+        {
+            transferError(job.get(), "read", source, -error);
+        }
+        for(int i = 0; i < children.size(); i++)
+        {
+            copyEntry(job, source + "/" + children.at(i).path, target + "/" + children.at(i).path);
+        }
+    }
+    else if(S_ISLNK(info.st_mode))
+    {
+        //links are copied as links
+        char link[PATH_MAX];
+        ssize_t length = readlink(source.c_str(), link, sizeof(link) - 1);
+        if(length < 0 || symlink(std::string(link, length).c_str(), target.c_str()) != 0)
+        {
+            transferError(job.get(), "copy link", source, errno);
+            return;
+        }
+        job->files_total++;
+        job->files_done++;
+    }
+    else if(S_ISREG(info.st_mode))
+    {
+        //each file is its own task, so the small files of a tree copy in parallel
+        job->files_total++;
+        job->bytes_total += info.st_size;
+        job->outstanding++;
+        mode_t mode = info.st_mode & 0777;
+        submitTask(job->pool, &job->group, [job, source, target, mode]() {
+            copyFile(job.get(), source, target, mode);
+            releaseJob(job.get());
+        });
+    }
+    else
+    {
+        transferError(job.get(), "copy special file", source, ENOTSUP);
+    }
+}
+
+void copyFile(TransferJob *job, const std::string &source, const std::string &target, mode_t mode)
+{
+    if(job->cancelled)
+    {
+        return;
+    }
+    TRACE_SCOPE("copyFile");
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if(in < 0)
+    {
+        transferError(job, "read", source, errno);
+        return;
+    }
+    //never overwrites; the file stays private until its permissions are set
+    int out = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if(out < 0)
+    {
+        transferError(job, "create", target, errno);
+        close(in);
+        return;
+    }
+
+    //the kernel copies between the two files [reflinks or server-side copies where the filesystem can];
+    //sendfile takes over where copy_file_range is not supported, e.g. across filesystems on older kernels
+    int error = 0;
+    bool use_sendfile = false;
+    while(!job->cancelled)
+    {
+        ssize_t copied;
+        if(!use_sendfile) {
+            copied = copy_file_range(in, NULL, out, NULL, TRANSFER_CHUNK, 0);
+        } else {
+            copied = sendfile(out, in, NULL, TRANSFER_CHUNK);
+        }
+        if(copied < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(!use_sendfile && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+            {
+                use_sendfile = true;
+                continue;
+            }
+            error = errno;
+            break;
+        }
+        if(copied == 0)
+        {
+            break;
+        }
+        job->bytes_done += copied;
+        notifyProgress(job, false);
+    }
+
+    if(error == 0 && !job->cancelled && fchmod(out, mode) != 0)
+    {
+        error = errno;
+    }
+    if(close(out) != 0 && error == 0)
+    {
+        error = errno;
+    }
+    close(in);
+    if(error != 0 || job->cancelled)
+    {
+        //no partly written file is left behind
+        unlink(target.c_str());
+        if(error != 0)
+        {
+            transferError(job, "copy", source, error);
+        }
+        return;
+    }
+    job->files_done++;
+}
+
+void removeEntry(TransferJob *job, const std::string &path)
+{
+    //depth first; stops between entries when cancelled
+    if(job->cancelled)
+    {
+        return;
+    }
+    struct stat info;
+    if(lstat(path.c_str(), &info) != 0)
+    {
+        transferError(job, "delete", path, errno);
+        return;
+    }
+    if(S_ISDIR(info.st_mode))
+    {
+        std::vector<EntryMeta> children;
+        ScanStats stats = {0, 0, 0};
+        int error = scanDirectory(path, SCAN_TYPE, &children, &stats);
+        if(error != 0)
+        {
+            transferError(job, "read", path, -error);
+            return;
+        }
+        for(int i = 0; i < children.size(); i++)
+        {
+            removeEntry(job, path + "/" + children.at(i).path);
+        }
+        if(job->cancelled)
+        {
+            return;
+        }
+    }
+    if((S_ISDIR(info.st_mode) ? rmdir(path.c_str()) : unlink(path.c_str())) != 0)
+    {
+        transferError(job, "delete", path, errno);
+        return;
+    }
+    job->files_done++;
+    notifyProgress(job, false);
+}
+
+void releaseJob(TransferJob *job)
+{
+    if(--job->outstanding > 0)
+    {
+        return;
+    }
+    //every file is in: directories get their permissions, deepest first, and a move removes what it copied
+    std::lock_guard<std::mutex> guard(job->lock);
+    for(int i = job->directories.size() - 1; i >= 0; i--)
+    {
+        chmod(job->directories.at(i).first.c_str(), job->directories.at(i).second);
+    }
+    if(!job->cancelled && job->errors == 0)
+    {
+        for(int i = 0; i < job->moved.size(); i++)
+        {
+            removeEntry(job, job->moved.at(i));
+        }
+    }
+    job->finished = true;
+    notifyProgress(job, true);
+}
+
+void notifyProgress(TransferJob *job, bool force)
+{
+    //at most one wake-up per interval, from whichever worker gets there first
+    Uint32 now = SDL_GetTicks();
+    Uint32 last = job->last_notify;
+    if(!force && (now - last < TRANSFER_PROGRESS_MS || !job->last_notify.compare_exchange_strong(last, now)))
+    {
+        return;
+    }
+    SDL_Event event;
+    SDL_memset(&event, 0, sizeof(event));
+    event.type = job->event_type;
+    SDL_PushEvent(&event);
+}
+
+void transferError(TransferJob *job, const char *action, const std::string &path, int error)
+{
+    fprintf(stderr, "Error: could not %s '%s': %s\n", action, path.c_str(), strerror(error));
+    job->errors++;
+}
+
+std::string uniqueTarget(const std::string &directory, const std::string &name, std::set<std::string> *taken)
+{
+    //"a.txt" pasted where it already exists becomes "a (copy).txt", then "a (copy 2).txt"
+    std::string target = directory + "/" + name;
+    size_t dot = name.rfind('.');
+    if(dot == 0 || dot == std::string::npos)
+    {
+        dot = name.length();
+    }
+    struct stat info;
+    for(int n = 1; taken->count(target) > 0 || lstat(target.c_str(), &info) == 0; n++)
+    {
+        std::string suffix = (n == 1) ? " (copy)" : " (copy " + std::to_string(n) + ")";
+        target = directory + "/" + name.substr(0, dot) + suffix + name.substr(dot);
+    }
+    taken->insert(target);
+    return target;
+}
+
+std::string baseName(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
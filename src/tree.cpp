@@ -0,0 +1,150 @@
+#include "tree.h"
+#include <algorithm>
+
+void addHiddenRanges(TreeView *view, EntryTable *table, int first, int end);
+void countHidden(TreeView *view);
+bool isHidden(TreeView *view, int i);
+
+void resetTreeView(TreeView *view)
+{
+    view->hidden_start.clear();
+    view->hidden_end.clear();
+    view->hidden_before.clear();
+    view->hidden = 0;
+}
+
+void rebuildTreeView(TreeView *view, EntryTable *table)
+{
+    //after rows moved: one pass over the flags finds every collapsed subtree again
+    resetTreeView(view);
+    addHiddenRanges(view, table, 0, entryCount(table));
+    countHidden(view);
+}
+
+void collapseEntry(TreeView *view, EntryTable *table, int i)
+{
+    //no rows move; ranges nested in the new one are covered by it
+    table->flags.at(i) |= ENTRY_COLLAPSED;
+    if(isHidden(view, i))
+    {
+        return;
+    }
+    int start = i + 1;
+    int end = start + subtreeSize(table, i);
+    int first = std::lower_bound(view->hidden_start.begin(), view->hidden_start.end(), start) - view->hidden_start.begin();
+    int last = std::lower_bound(view->hidden_start.begin(), view->hidden_start.end(), end) - view->hidden_start.begin();
+    view->hidden_start.erase(view->hidden_start.begin() + first, view->hidden_start.begin() + last);
+    view->hidden_end.erase(view->hidden_end.begin() + first, view->hidden_end.begin() + last);
+    if(end > start)
+    {
+        view->hidden_start.insert(view->hidden_start.begin() + first, start);
+        view->hidden_end.insert(view->hidden_end.begin() + first, end);
+    }
+    countHidden(view);
+}
+
+void uncollapseEntry(TreeView *view, EntryTable *table, int i)
+{
+    //the range goes away, but collapsed directories inside it stay hidden
+    table->flags.at(i) &= ~ENTRY_COLLAPSED;
+    if(isHidden(view, i))
+    {
+        return;
+    }
+    int k = std::lower_bound(view->hidden_start.begin(), view->hidden_start.end(), i + 1) - view->hidden_start.begin();
+    if(k == view->hidden_start.size() || view->hidden_start.at(k) != i + 1)
+    {
+        return;
+    }
+    int end = view->hidden_end.at(k);
+    view->hidden_start.erase(view->hidden_start.begin() + k);
+    view->hidden_end.erase(view->hidden_end.begin() + k);
+
+    TreeView nested;
+    resetTreeView(&nested);
+    addHiddenRanges(&nested, table, i + 1, end);
+    view->hidden_start.insert(view->hidden_start.begin() + k, nested.hidden_start.begin(), nested.hidden_start.end());
+    view->hidden_end.insert(view->hidden_end.begin() + k, nested.hidden_end.begin(), nested.hidden_end.end());
+    countHidden(view);
+}
+
+bool hasHiddenRows(TreeView *view)
+{
+    return !view->hidden_start.empty();
+}
+
+int visibleCount(TreeView *view, EntryTable *table)
+{
+    return entryCount(table) - view->hidden;
+}
+
+int visibleEntry(TreeView *view, int row)
+{
+    //the last range starting at or before this row's position is skipped over, with all before it
+    int low = 0;
+    int high = view->hidden_start.size();
+    while(low < high)
+    {
+        int middle = (low + high)/2;
+        if(view->hidden_start.at(middle) - view->hidden_before.at(middle) <= row) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if(low == 0)
+    {
+        return row;
+    }
+    int k = low - 1;
+    return row + view->hidden_before.at(k) + view->hidden_end.at(k) - view->hidden_start.at(k);
+}
+
+int visibleRow(TreeView *view, int i)
+{
+    //a hidden entry maps to the row of the collapsed directory above it
+    int k = std::upper_bound(view->hidden_start.begin(), view->hidden_start.end(), i) - view->hidden_start.begin() - 1;
+    if(k < 0)
+    {
+        return i;
+    }
+    if(i < view->hidden_end.at(k))
+    {
+        return view->hidden_start.at(k) - 1 - view->hidden_before.at(k);
+    }
+    return i - view->hidden_before.at(k) - (view->hidden_end.at(k) - view->hidden_start.at(k));
+}
+
+void addHiddenRanges(TreeView *view, EntryTable *table, int first, int end)
+{
+    for(int i = first; i < end; i++)
+    {
+        if((table->flags.at(i) & ENTRY_COLLAPSED) && i + 1 < end)
+        {
+            int size = subtreeSize(table, i);
+            if(size > 0)
+            {
+                view->hidden_start.push_back(i + 1);
+                view->hidden_end.push_back(std::min(end, i + 1 + size));
+                i += size;
+            }
+        }
+    }
+}
+
+bool isHidden(TreeView *view, int i)
+{
+    int k = std::upper_bound(view->hidden_start.begin(), view->hidden_start.end(), i) - view->hidden_start.begin() - 1;
+    return k >= 0 && i < view->hidden_end.at(k);
+}
+
+void countHidden(TreeView *view)
+{
+    view->hidden_before.resize(view->hidden_start.size());
+    view->hidden = 0;
+    for(int k = 0; k < view->hidden_start.size(); k++)
+    {
+        view->hidden_before.at(k) = view->hidden;
+        view->hidden += view->hidden_end.at(k) - view->hidden_start.at(k);
+    }
+}
@@ -0,0 +1,395 @@
+#include "treeindex.h"
+#include "walk.h"
+#include "filter.h"
+#include "sort.h"
+#include "trace.h"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//listing gathered by a refresh, before it is written out
+typedef struct IndexedListing {
+    std::string path;
+    DirectoryStamp stamp;
+    std::vector<EntryMeta> entries;
+} IndexedListing;
+
+typedef struct IndexBuild {
+    ThreadPool *pool;
+    TaskGroup *group;
+    std::shared_ptr<TreeIndex> current;
+    std::mutex lock;
+    std::vector<IndexedListing> listings;
+} IndexBuild;
+
+void refreshIndex(IndexRefresh *refresh, std::string root, std::string filename, ThreadPool *pool, DirectoryCache *cache);
+void indexDirectory(std::shared_ptr<IndexBuild> build, std::string dirname);
+bool writeTreeIndex(const std::string &filename, std::vector<IndexedListing> *listings);
+bool writeAll(int fd, const void *data, size_t length);
+
+std::string defaultIndexFile()
+{
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    std::string base = (cache_home != NULL && cache_home[0] != '\0') ? cache_home : std::string(getenv("HOME")) + "/.cache";
+    return base + "/fileexplorer/tree.index";
+}
+
+std::shared_ptr<TreeIndex> openTreeIndex(const std::string &filename)
+{
+    //a missing index is normal on first use; it is written by the first refresh
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IndexHeader))
+    {
+        close(fd);
+        fprintf(stderr, "Error: index '%s' is truncated, it will be rebuilt\n", filename.c_str());
+        return NULL;
+    }
+    void *map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: index '%s' could not be mapped: %s\n", filename.c_str(), strerror(errno));
+        return NULL;
+    }
+
+    std::shared_ptr<TreeIndex> index = std::make_shared<TreeIndex>();
+    index->map = map;
+    index->map_size = info.st_size;
+    index->header = (const IndexHeader*)map;
+
+    //sections must exactly fill the file; counts are bounded by the size first so nothing overflows
+    const IndexHeader *header = index->header;
+    uint64_t size = info.st_size;
+    bool valid = memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == INDEX_VERSION && header->byte_order == INDEX_BYTE_ORDER &&
+                 header->file_size == size && header->directory_count <= size/sizeof(IndexDirectory) &&
+                 header->entry_count <= size/sizeof(IndexEntry) && header->names_size <= size &&
+                 sizeof(IndexHeader) + header->directory_count*sizeof(IndexDirectory) +
+                 header->entry_count*sizeof(IndexEntry) + header->names_size == size;
+    if(!valid)
+    {
+        fprintf(stderr, "Error: index '%s' has an unknown format, it will be rebuilt\n", filename.c_str());
+        return NULL;
+    }
+    const char *base = (const char*)map;
+    index->directories = (const IndexDirectory*)(base + sizeof(IndexHeader));
+    index->entries = (const IndexEntry*)(index->directories + header->directory_count);
+    index->names = (const char*)(index->entries + header->entry_count);
+    return index;
+}
+
+TreeIndex::~TreeIndex()
+{
+    munmap(map, map_size);
+}
+
+bool lookupIndexedListing(TreeIndex *index, const std::string &dirname, const DirectoryStamp &stamp, std::vector<EntryMeta> *entries)
+{
+    //binary search by path, bytewise
+    const IndexHeader *header = index->header;
+    uint64_t low = 0;
+    uint64_t high = header->directory_count;
+    const IndexDirectory *directory = NULL;
+    while(low < high)
+    {
+        uint64_t middle = low + (high - low)/2;
+        const IndexDirectory *candidate = &index->directories[middle];
+        if(candidate->path_offset + candidate->path_length > header->names_size)
+        {
+            return false;
+        }
+        int cmp = memcmp(index->names + candidate->path_offset, dirname.data(), std::min<size_t>(candidate->path_length, dirname.length()));
+        if(cmp == 0)
+        {
+            cmp = (candidate->path_length < dirname.length()) ? -1 : (candidate->path_length > dirname.length());
+        }
+        if(cmp == 0)
+        {
+            directory = candidate;
+            break;
+        }
+        if(cmp < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    //only a directory that has not changed since it was indexed is trusted
+    if(directory == NULL || directory->device != stamp.device || directory->inode != stamp.inode ||
+       directory->mtime_ns != stamp.mtime_ns || directory->ctime_ns != stamp.ctime_ns ||
+       directory->first_entry + directory->entry_count > header->entry_count)
+    {
+        return false;
+    }
+
+    entries->clear();
+    entries->reserve(directory->entry_count);
+    for(uint64_t i = directory->first_entry; i < directory->first_entry + directory->entry_count; i++)
+    {
+        const IndexEntry *entry = &index->entries[i];
+        if((uint64_t)entry->name_offset + entry->name_length > header->names_size)
+        {
+            entries->clear();
+            return false;
+        }
+        EntryMeta meta;
+        meta.path.assign(index->names + entry->name_offset, entry->name_length);
+        meta.mode = entry->mode;
+        meta.size = entry->size;
+        meta.mtime = entry->mtime;
+        meta.is_directory = (entry->flags & INDEX_DIRECTORY) != 0;
+        meta.is_link = (entry->flags & INDEX_LINK) != 0;
+        entries->push_back(std::move(meta));
+    }
+    return true;
+}
+
+std::vector<std::string> searchTreeIndex(TreeIndex *index, const std::string &query, bool fuzzy, size_t limit, ThreadPool *pool)
+{
+    TRACE_SCOPE("searchTreeIndex");
+    //names are folded one at a time into a padded buffer [the mapping is read-only and matchName reads past the end]
+    const IndexHeader *header = index->header;
+    std::string folded_query(query.length(), '\0');
+    foldCase(query.data(), query.length(), &folded_query[0]);
+    uint64_t chunks = (header->entry_count + INDEX_SEARCH_CHUNK - 1)/INDEX_SEARCH_CHUNK;
+    std::vector<std::vector<uint64_t> > found(chunks);
+    TaskGroup group;
+    initializeTaskGroup(&group);
+    for(uint64_t c = 0; c < chunks; c++)
+    {
+        submitTask(pool, &group, [index, header, &folded_query, fuzzy, &found, c]() {
+            std::vector<char> name(UINT16_MAX + 16);
+            uint64_t end = std::min<uint64_t>(header->entry_count, (c + 1)*INDEX_SEARCH_CHUNK);
+            for(uint64_t i = c*INDEX_SEARCH_CHUNK; i < end; i++)
+            {
+                const IndexEntry *entry = &index->entries[i];
+                if((uint64_t)entry->name_offset + entry->name_length > header->names_size || entry->parent >= header->directory_count)
+                {
+                    continue;
+                }
+                foldCase(index->names + entry->name_offset, entry->name_length, name.data());
+                if(matchName(name.data(), entry->name_length, folded_query.data(), folded_query.length(), fuzzy))
+                {
+                    found.at(c).push_back(i);
+                }
+            }
+        });
+    }
+    waitForTasks(pool, &group);
+
+    //index order: directories by path, each one's entries in listing order
+    std::vector<std::string> paths;
+    for(uint64_t c = 0; c < chunks; c++)
+    {
+        for(int i = 0; i < found.at(c).size() && (limit == 0 || paths.size() < limit); i++)
+        {
+            const IndexEntry *entry = &index->entries[found.at(c).at(i)];
+            const IndexDirectory *directory = &index->directories[entry->parent];
+            if(directory->path_offset + directory->path_length > header->names_size)
+            {
+                continue;
+            }
+            std::string path(index->names + directory->path_offset, directory->path_length);
+            if(path != "/")
+            {
+                path.append("/");
+            }
+            path.append(index->names + entry->name_offset, entry->name_length);
+            paths.push_back(std::move(path));
+        }
+    }
+    return paths;
+}
+
+void startIndexRefresh(IndexRefresh *refresh, const std::string &root, const std::string &filename, ThreadPool *pool, DirectoryCache *cache)
+{
+    //the walk itself runs on the pool; this thread only waits for it and writes the file
+    stopIndexRefresh(refresh);
+    initializeTaskGroup(&refresh->group);
+    refresh->running = true;
+    refresh->worker = std::thread(refreshIndex, refresh, root, filename, pool, cache);
+}
+
+void stopIndexRefresh(IndexRefresh *refresh)
+{
+    refresh->group.cancelled = true;
+    if(refresh->worker.joinable())
+    {
+        refresh->worker.join();
+    }
+    refresh->running = false;
+}
+
+void refreshIndex(IndexRefresh *refresh, std::string root, std::string filename, ThreadPool *pool, DirectoryCache *cache)
+{
+    traceThreadName("index refresh");
+    std::shared_ptr<IndexBuild> build = std::make_shared<IndexBuild>();
+    build->pool = pool;
+    build->group = &refresh->group;
+    build->current = getCacheTree(cache);
+    submitTask(pool, &refresh->group, [build, root]() {
+        indexDirectory(build, root);
+    });
+    waitForTasks(pool, &refresh->group);
+
+    //the new file replaces the old one in a single rename, then the walker switches over to it
+    if(!refresh->group.cancelled && writeTreeIndex(filename, &build->listings))
+    {
+        std::shared_ptr<TreeIndex> index = openTreeIndex(filename);
+        if(index)
+        {
+            setCacheTree(cache, index);
+        }
+    }
+    refresh->running = false;
+}
+
+void indexDirectory(std::shared_ptr<IndexBuild> build, std::string dirname)
+{
+    //stamped before reading, so a change during the read makes the entry stale rather than wrong
+    IndexedListing listing;
+    listing.path = dirname;
+    if(build->group->cancelled || !stampDirectory(dirname, &listing.stamp))
+    {
+        return;
+    }
+    if(!build->current || !lookupIndexedListing(build->current.get(), dirname, listing.stamp, &listing.entries))
+    {
+        if(scanDirectory(dirname, SCAN_TYPE | SCAN_METADATA, &listing.entries, NULL) != 0)
+        {
+            return;
+        }
+        sortEntries(&listing.entries);
+    }
+
+    //same rule as the walker: real, visible subdirectories
+    for(int i = 0; i < listing.entries.size(); i++)
+    {
+        EntryMeta *entry = &listing.entries.at(i);
+        if(entry->is_directory && !entry->is_link && entry->path.at(0) != '.')
+        {
+            std::string path = dirname + "/" + entry->path;
+            submitTask(build->pool, build->group, [build, path]() {
+                indexDirectory(build, path);
+            });
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(build->lock);
+    build->listings.push_back(std::move(listing));
+}
+
+bool writeTreeIndex(const std::string &filename, std::vector<IndexedListing> *listings)
+{
+    TRACE_SCOPE("writeTreeIndex");
+    std::sort(listings->begin(), listings->end(), [](const IndexedListing &a, const IndexedListing &b) {
+        return a.path < b.path;
+    });
+
+    //flatten into the on-disk sections
+    std::vector<IndexDirectory> directories;
+    std::vector<IndexEntry> entries;
+    std::string names;
+    for(int d = 0; d < listings->size(); d++)
+    {
+        IndexedListing *listing = &listings->at(d);
+        IndexDirectory directory;
+        directory.device = listing->stamp.device;
+        directory.inode = listing->stamp.inode;
+        directory.mtime_ns = listing->stamp.mtime_ns;
+        directory.ctime_ns = listing->stamp.ctime_ns;
+        directory.path_offset = names.size();
+        directory.path_length = listing->path.length();
+        directory.entry_count = listing->entries.size();
+        directory.first_entry = entries.size();
+        names += listing->path;
+        directories.push_back(directory);
+
+        for(int i = 0; i < listing->entries.size(); i++)
+        {
+            EntryMeta *meta = &listing->entries.at(i);
+            if(names.size() + meta->path.length() > UINT32_MAX)
+            {
+                fprintf(stderr, "Error: tree is too large to index\n");
+                return false;
+            }
+            IndexEntry entry;
+            entry.size = meta->size;
+            entry.mtime = meta->mtime;
+            entry.name_offset = names.size();
+            entry.mode = meta->mode;
+            entry.parent = d;
+            entry.name_length = meta->path.length();
+            entry.flags = (meta->is_directory ? INDEX_DIRECTORY : 0) | (meta->is_link ? INDEX_LINK : 0);
+            entry.unused = 0;
+            names += meta->path;
+            entries.push_back(entry);
+        }
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.byte_order = INDEX_BYTE_ORDER;
+    header.directory_count = directories.size();
+    header.entry_count = entries.size();
+    header.names_size = names.size();
+    header.file_size = sizeof(header) + directories.size()*sizeof(IndexDirectory) + entries.size()*sizeof(IndexEntry) + names.size();
+
+    //written to a private file next to the index, flushed, then renamed over it
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+    std::string temporary = filename + ".tmp." + std::to_string(getpid());
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: index '%s' could not be written: %s\n", temporary.c_str(), strerror(errno));
+        return false;
+    }
+    bool written = writeAll(fd, &header, sizeof(header)) &&
+                   writeAll(fd, directories.data(), directories.size()*sizeof(IndexDirectory)) &&
+                   writeAll(fd, entries.data(), entries.size()*sizeof(IndexEntry)) &&
+                   writeAll(fd, names.data(), names.size()) &&
+                   fsync(fd) == 0;
+    close(fd);
+    if(!written || rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        fprintf(stderr, "Error: index '%s' could not be written: %s\n", filename.c_str(), strerror(errno));
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const void *data, size_t length)
+{
+    const char *position = (const char*)data;
+    while(length > 0)
+    {
+        ssize_t written = write(fd, position, length);
+        if(written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(written <= 0)
+        {
+            return false;
+        }
+        position += written;
+        length -= written;
+    }
+    return true;
+}
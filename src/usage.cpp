@@ -0,0 +1,259 @@
+#include "usage.h"
+#include "trace.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+UsageNode* addNode(UsageJob *job, const std::string &path, uint64_t device, UsageNode *parent);
+void scanUsage(std::shared_ptr<UsageJob> job, UsageNode *node);
+bool readUsage(const std::string &dirname, UsageRecord *record);
+void addToAncestors(UsageNode *node, uint64_t bytes, uint64_t files);
+void finishNode(UsageJob *job, UsageNode *node);
+
+void initializeUsageCache(UsageCache *cache)
+{
+    cache->records.clear();
+}
+
+void forgetUsage(UsageCache *cache, const std::string &dirname)
+{
+    DirectoryStamp stamp;
+    if(!stampDirectory(dirname, &stamp))
+    {
+        return;
+    }
+    InodeKey key = {stamp.device, stamp.inode};
+    std::lock_guard<std::mutex> guard(cache->lock);
+    cache->records.erase(key);
+}
+
+std::shared_ptr<UsageJob> startUsage(const std::vector<std::string> &directories, ThreadPool *pool, UsageCache *cache, UsageEmitter emit)
+{
+    std::shared_ptr<UsageJob> job = std::make_shared<UsageJob>();
+    job->pool = pool;
+    job->cache = cache;
+    job->emit = emit;
+    job->remaining = directories.size();
+    initializeTaskGroup(&job->group);
+
+    //roots are registered up front so each has an entry from the start [paths must be distinct]
+    std::vector<UsageNode*> roots;
+    for(int i = 0; i < directories.size(); i++)
+    {
+        roots.push_back(addNode(job.get(), directories.at(i), 0, NULL));
+    }
+    for(int i = 0; i < roots.size(); i++)
+    {
+        UsageNode *root = roots.at(i);
+        submitTask(pool, &job->group, [job, root]() {
+            scanUsage(job, root);
+        });
+    }
+    if(directories.empty())
+    {
+        job->emit(true);
+    }
+    return job;
+}
+
+void cancelUsage(UsageJob *job)
+{
+    job->group.cancelled = true;
+}
+
+bool getUsage(UsageJob *job, const std::string &path, DirectoryUsage *usage)
+{
+    std::lock_guard<std::mutex> guard(job->lock);
+    std::unordered_map<std::string, UsageNode*>::iterator found = job->nodes.find(path);
+    if(found == job->nodes.end())
+    {
+        return false;
+    }
+    usage->bytes = found->second->bytes;
+    usage->files = found->second->files;
+    usage->complete = found->second->pending == 0;
+    return true;
+}
+
+bool isUsageFinished(UsageJob *job)
+{
+    return job->remaining == 0;
+}
+
+UsageJob::~UsageJob()
+{
+    for(std::unordered_map<std::string, UsageNode*>::iterator it = nodes.begin(); it != nodes.end(); it++)
+    {
+        delete it->second;
+    }
+}
+
+UsageNode* addNode(UsageJob *job, const std::string &path, uint64_t device, UsageNode *parent)
+{
+    UsageNode *node = new UsageNode();
+    node->path = path;
+    node->device = device;
+    node->parent = parent;
+    node->bytes = 0;
+    node->files = 0;
+    node->pending = 1;
+
+    std::lock_guard<std::mutex> guard(job->lock);
+    job->nodes[path] = node;
+    return node;
+}
+
+void scanUsage(std::shared_ptr<UsageJob> job, UsageNode *node)
+{
+    TRACE_SCOPE("scanUsage");
+    //mount points below a root are left out, like du -x
+    DirectoryStamp stamp;
+    bool stamped = stampDirectory(node->path, &stamp);
+    if(!stamped || (node->parent != NULL && stamp.device != node->device) || job->group.cancelled)
+    {
+        finishNode(job.get(), node);
+        return;
+    }
+    node->device = stamp.device;
+
+    //an unchanged directory is replayed from the cache instead of read again
+    UsageRecord record;
+    InodeKey key = {stamp.device, stamp.inode};
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> guard(job->cache->lock);
+        std::unordered_map<InodeKey, UsageRecord, InodeHash>::iterator found = job->cache->records.find(key);
+        if(found != job->cache->records.end() && found->second.stamp.mtime_ns == stamp.mtime_ns && found->second.stamp.ctime_ns == stamp.ctime_ns)
+        {
+            record = found->second;
+            cached = true;
+        }
+    }
+    if(!cached)
+    {
+        record.stamp = stamp;
+        if(!readUsage(node->path, &record))
+        {
+            finishNode(job.get(), node);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(job->cache->lock);
+        if(job->cache->records.size() >= USAGE_CACHE_LIMIT)
+        {
+            job->cache->records.clear();
+        }
+        job->cache->records[key] = record;
+    }
+
+    //hard links count only the first time they are seen in this job
+    uint64_t bytes = record.bytes;
+    uint64_t files = record.files;
+    if(!record.links.empty())
+    {
+        std::lock_guard<std::mutex> guard(job->lock);
+        for(int i = 0; i < record.links.size(); i++)
+        {
+            if(job->linked.insert(record.links.at(i).key).second)
+            {
+                bytes += record.links.at(i).size;
+                files++;
+            }
+        }
+    }
+    addToAncestors(node, bytes, files);
+
+    for(int i = 0; i < record.subdirectories.size() && !job->group.cancelled; i++)
+    {
+        UsageNode *child = addNode(job.get(), node->path + "/" + record.subdirectories.at(i), stamp.device, node);
+        node->pending++;
+        submitTask(job->pool, &job->group, [job, child]() {
+            scanUsage(job, child);
+        });
+    }
+    finishNode(job.get(), node);
+}
+
+bool readUsage(const std::string &dirname, UsageRecord *record)
+{
+    record->bytes = 0;
+    record->files = 0;
+    record->subdirectories.clear();
+    record->links.clear();
+
+    int dirfd = open(dirname.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dirfd < 0)
+    {
+        return false;
+    }
+    DIR *dir = fdopendir(dirfd);
+    if(dir == NULL)
+    {
+        close(dirfd);
+        return false;
+    }
+
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        const char *name = entry->d_name;
+        if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+        {
+            continue;
+        }
+
+        //subdirectories need no stat here, they are stamped when they are read
+        if(entry->d_type == DT_DIR)
+        {
+            record->subdirectories.push_back(name);
+            continue;
+        }
+        struct stat info;
+        if(fstatat(dirfd, name, &info, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            continue;
+        }
+        if(S_ISDIR(info.st_mode)) {
+            record->subdirectories.push_back(name);
+        } else if(info.st_nlink > 1) {
+            record->links.push_back({{(uint64_t)info.st_dev, (uint64_t)info.st_ino}, (uint64_t)info.st_size});
+        } else {
+            record->bytes += info.st_size;
+            record->files++;
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+void addToAncestors(UsageNode *node, uint64_t bytes, uint64_t files)
+{
+    for(UsageNode *ancestor = node; ancestor != NULL; ancestor = ancestor->parent)
+    {
+        ancestor->bytes += bytes;
+        ancestor->files += files;
+    }
+}
+
+void finishNode(UsageJob *job, UsageNode *node)
+{
+    //a directory is complete once it and all of its subdirectories are
+    while(node != NULL && --node->pending == 0)
+    {
+        if(node->parent == NULL)
+        {
+            bool finished = --job->remaining == 0;
+            if(!job->group.cancelled)
+            {
+                job->emit(finished);
+            }
+            return;
+        }
+        node = node->parent;
+    }
+    if(!job->group.cancelled)
+    {
+        job->emit(false);
+    }
+}
@@ -0,0 +1,229 @@
+#include "walk.h"
+#include "sort.h"
+#include <algorithm>
+#include <string.h>
+
+void scanNode(std::shared_ptr<WalkJob> job, WalkNode *node);
+void submitNode(std::shared_ptr<WalkJob> job, WalkNode *node);
+void advanceWalk(std::shared_ptr<WalkJob> job);
+void freeNode(WalkNode *node, int from);
+
+std::shared_ptr<WalkJob> startWalk(const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, WalkEmitter emit)
+{
+    std::shared_ptr<WalkJob> job = std::make_shared<WalkJob>();
+    job->pool = pool;
+    job->max_depth = max_depth;
+    job->cache = cache;
+    job->emit = emit;
+    job->stats = {0, 0, 0};
+    job->buffered = 0;
+    job->scans = 0;
+    initializeTaskGroup(&job->group);
+
+    //tasks hold the job alive, so a caller may drop it while the walk still runs
+    WalkNode *root = new WalkNode();
+    root->path = dirname;
+    root->depth = 0;
+    job->cursor.push_back(std::make_pair(root, 0));
+    std::lock_guard<std::mutex> guard(job->lock);
+    submitNode(job, root);
+    return job;
+}
+
+void cancelWalk(WalkJob *job)
+{
+    //queued scans are skipped and nothing more is emitted
+    job->group.cancelled = true;
+}
+
+std::vector<EntryMeta> walkDirectory(const std::string &dirname, int max_depth, ThreadPool *pool, DirectoryCache *cache, ScanStats *stats)
+{
+    std::vector<EntryMeta> files;
+    std::shared_ptr<WalkJob> job = startWalk(dirname, max_depth, pool, cache, [&files](std::vector<EntryMeta> *batch, bool) {
+        std::move(batch->begin(), batch->end(), std::back_inserter(files));
+    });
+    waitForTasks(pool, &job->group);
+    if(stats != NULL)
+    {
+        stats->directories += job->stats.directories;
+        stats->entries += job->stats.entries;
+        stats->stat_calls += job->stats.stat_calls;
+    }
+    return files;
+}
+
+WalkJob::~WalkJob()
+{
+    //only reached once every task is done; free whatever was never emitted
+    for(int i = 0; i < cursor.size(); i++)
+    {
+        freeNode(cursor.at(i).first, cursor.at(i).second);
+    }
+}
+
+void submitNode(std::shared_ptr<WalkJob> job, WalkNode *node)
+{
+    //called with the job locked
+    node->submitted = true;
+    job->scans++;
+    submitTask(job->pool, &job->group, [job, node]() {
+        scanNode(job, node);
+    });
+}
+
+void scanNode(std::shared_ptr<WalkJob> job, WalkNode *node)
+{
+    const std::string &dirname = node->path;
+    node->stats = {0, 0, 0};
+    node->error = 0;
+
+    //an unchanged directory is served from the cache for the price of one statx
+    DirectoryStamp stamp;
+    bool stamped = job->cache != NULL && stampDirectory(dirname, &stamp);
+    if(!stamped || !lookupListing(job->cache, dirname, stamp, &node->entries))
+    {
+        node->error = scanDirectory(dirname, SCAN_TYPE | SCAN_METADATA, &node->entries, &node->stats);
+        if(node->error != 0)
+        {
+            fprintf(stderr, "Error: directory '%s' could not be read: %s\n", dirname.c_str(), strerror(-node->error));
+        }
+
+        //sort [paths are still bare names here]
+        sortEntries(&node->entries);
+        if(stamped && node->error == 0)
+        {
+            storeListing(job->cache, dirname, stamp, node->entries);
+        }
+    }
+
+    node->children.assign(node->entries.size(), NULL);
+    for(int i = 0; i < node->entries.size(); i++)
+    {
+        EntryMeta *entry = &(node->entries.at(i));
+        bool hidden = entry->path.at(0) == '.';
+        entry->path = dirname + "/" + entry->path;
+
+        //descend into real (not symlinked) visible subdirectories, each on its own task
+        bool within_depth = (job->max_depth == WALK_UNLIMITED || node->depth < job->max_depth);
+        if(entry->is_directory && !entry->is_link && !hidden && within_depth && !job->group.cancelled)
+        {
+            WalkNode *child = new WalkNode();
+            child->path = entry->path;
+            child->depth = node->depth + 1;
+            node->children.at(i) = child;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(job->lock);
+    node->ready = true;
+    job->scans--;
+    job->buffered += node->entries.size();
+    job->stats.directories += node->stats.directories;
+    job->stats.entries += node->stats.entries;
+    job->stats.stat_calls += node->stats.stat_calls;
+    //subdirectories are queued for scanning in reverse, so the first one is scanned first
+    for(int i = node->children.size() - 1; i >= 0; i--)
+    {
+        if(node->children.at(i) != NULL)
+        {
+            job->deferred.push_back(node->children.at(i));
+        }
+    }
+    advanceWalk(job);
+}
+
+void advanceWalk(std::shared_ptr<WalkJob> job)
+{
+    //emit from the cursor until reaching a directory that is still being scanned
+    std::vector<EntryMeta> batch;
+    while(!job->cursor.empty() && job->cursor.back().first->ready)
+    {
+        WalkNode *node = job->cursor.back().first;
+        int i = job->cursor.back().second;
+        if(i == node->entries.size())
+        {
+            delete node;
+            job->cursor.pop_back();
+            continue;
+        }
+        job->cursor.back().second++;
+        job->buffered--;
+        batch.push_back(std::move(node->entries.at(i)));
+        if(node->children.at(i) != NULL)
+        {
+            job->cursor.push_back(std::make_pair(node->children.at(i), 0));
+        }
+    }
+
+    bool finished = job->cursor.empty();
+    if((!batch.empty() || finished) && !job->group.cancelled)
+    {
+        job->emit(&batch, finished);
+    }
+    if(job->group.cancelled)
+    {
+        return;
+    }
+
+    //the directory emission waits on is scanned whatever the limits, so the walk always moves on
+    //[taken out of the held-back ones, which only ever hold unsubmitted nodes]
+    if(!finished && !job->cursor.back().first->submitted)
+    {
+        WalkNode *next = job->cursor.back().first;
+        std::vector<WalkNode*>::reverse_iterator held = std::find(job->deferred.rbegin(), job->deferred.rend(), next);
+        if(held != job->deferred.rend())
+        {
+            job->deferred.erase(std::next(held).base());
+        }
+        submitNode(job, next);
+    }
+    //scan ahead while the consumer keeps up
+    while(!job->deferred.empty() && job->buffered < WALK_MAX_BUFFERED && job->scans < WALK_MAX_SCANS)
+    {
+        WalkNode *node = job->deferred.back();
+        job->deferred.pop_back();
+        submitNode(job, node);
+    }
+}
+
+void freeNode(WalkNode *node, int from)
+{
+    for(int i = from; i < node->children.size(); i++)
+    {
+        if(node->children.at(i) != NULL)
+        {
+            freeNode(node->children.at(i), 0);
+        }
+    }
+    delete node;
+}
+
+void sortEntries(std::vector<EntryMeta> *entries)
+{
+    //fold every path once instead of on each comparison
+    std::vector<std::string> keys(entries->size());
+    std::vector<int> order(entries->size());
+    for(int i = 0; i < entries->size(); i++)
+    {
+        const std::string &path = entries->at(i).path;
+        keys.at(i).resize(path.length());
+        foldCase(path.data(), path.length(), &keys.at(i)[0]);
+        order.at(i) = i;
+    }
+    std::sort(order.begin(), order.end(), [entries, &keys](int a, int b) {
+        int cmp = naturalCompare(keys.at(a).data(), keys.at(a).length(), keys.at(b).data(), keys.at(b).length());
+        if(cmp != 0)
+        {
+            return cmp < 0;
+        }
+        return entries->at(a).path < entries->at(b).path;
+    });
+
+    std::vector<EntryMeta> sorted;
+    sorted.reserve(entries->size());
+    for(int i = 0; i < order.size(); i++)
+    {
+        sorted.push_back(std::move(entries->at(order.at(i))));
+    }
+    entries->swap(sorted);
+}
@@ -0,0 +1,180 @@
+#include "watch.h"
+#include "trace.h"
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_ONLYDIR)
+
+void readChanges(DirectoryWatch *watch);
+
+bool startWatch(DirectoryWatch *watch, Uint32 event_type)
+{
+    watch->event_type = event_type;
+    watch->overflowed = false;
+    watch->notified = false;
+    watch->limit_reported = false;
+    watch->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if(watch->inotify_fd < 0 || watch->stop_fd < 0)
+    {
+        fprintf(stderr, "Error: could not start directory watcher: %s\n", strerror(errno));
+        return false;
+    }
+    watch->reader = std::thread(readChanges, watch);
+    return true;
+}
+
+void stopWatch(DirectoryWatch *watch)
+{
+    if(watch->reader.joinable())
+    {
+        uint64_t one = 1;
+        write(watch->stop_fd, &one, sizeof(one));
+        watch->reader.join();
+    }
+    if(watch->inotify_fd >= 0)
+    {
+        close(watch->inotify_fd);
+    }
+    if(watch->stop_fd >= 0)
+    {
+        close(watch->stop_fd);
+    }
+    watch->inotify_fd = -1;
+    watch->stop_fd = -1;
+}
+
+bool watchDirectory(DirectoryWatch *watch, const std::string &dirname)
+{
+    if(watch->inotify_fd < 0)
+    {
+        return false;
+    }
+    int wd = inotify_add_watch(watch->inotify_fd, dirname.c_str(), WATCH_MASK);
+
+    std::lock_guard<std::mutex> guard(watch->lock);
+    if(wd < 0)
+    {
+        //typically fs.inotify.max_user_watches; the listing still works, just without live updates
+        if(errno == ENOSPC && !watch->limit_reported)
+        {
+            fprintf(stderr, "Error: inotify watch limit reached, some directories will not refresh\n");
+            watch->limit_reported = true;
+        }
+        return false;
+    }
+    watch->directories[wd] = dirname;
+    return true;
+}
+
+void clearWatches(DirectoryWatch *watch)
+{
+    std::lock_guard<std::mutex> guard(watch->lock);
+    for(std::unordered_map<int, std::string>::iterator it = watch->directories.begin(); it != watch->directories.end(); it++)
+    {
+        inotify_rm_watch(watch->inotify_fd, it->first);
+    }
+    watch->directories.clear();
+    watch->changed.clear();
+    watch->overflowed = false;
+    watch->limit_reported = false;
+}
+
+bool takeChanges(DirectoryWatch *watch, std::set<std::string> *changed)
+{
+    //returns true when events were lost and the caller should rescan instead
+    std::lock_guard<std::mutex> guard(watch->lock);
+    changed->swap(watch->changed);
+    watch->changed.clear();
+    watch->notified = false;
+    bool overflowed = watch->overflowed;
+    watch->overflowed = false;
+    return overflowed;
+}
+
+void readChanges(DirectoryWatch *watch)
+{
+    traceThreadName("watch");
+    alignas(struct inotify_event) char buffer[16384];
+    Uint32 first_change = 0;
+    bool pending = false;
+
+    while(true)
+    {
+        //sleep until the next event, or until the current burst has settled
+        int timeout = -1;
+        if(pending)
+        {
+            Uint32 elapsed = SDL_GetTicks() - first_change;
+            timeout = (elapsed >= WATCH_COALESCE_MS) ? 0 : WATCH_COALESCE_MS - elapsed;
+        }
+        struct pollfd fds[2] = {{watch->inotify_fd, POLLIN, 0}, {watch->stop_fd, POLLIN, 0}};
+        int ready = poll(fds, 2, timeout);
+        if(ready < 0 && errno != EINTR)
+        {
+            return;
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            return;
+        }
+
+        if(fds[0].revents & POLLIN)
+        {
+            ssize_t length;
+            while((length = read(watch->inotify_fd, buffer, sizeof(buffer))) > 0)
+            {
+                std::lock_guard<std::mutex> guard(watch->lock);
+                for(char *ptr = buffer; ptr < buffer + length; )
+                {
+                    struct inotify_event *event = (struct inotify_event *)ptr;
+                    ptr += sizeof(struct inotify_event) + event->len;
+
+                    if(event->mask & IN_Q_OVERFLOW)
+                    {
+                        watch->overflowed = true;
+                        continue;
+                    }
+                    std::unordered_map<int, std::string>::iterator dir = watch->directories.find(event->wd);
+                    if(dir == watch->directories.end())
+                    {
+                        continue;
+                    }
+                    if(event->mask & IN_IGNORED)
+                    {
+                        watch->directories.erase(dir);
+                        continue;
+                    }
+                    if(event->len > 0)
+                    {
+                        watch->changed.insert(dir->second + "/" + event->name);
+                    }
+                }
+                if(!pending && (!watch->changed.empty() || watch->overflowed))
+                {
+                    pending = true;
+                    first_change = SDL_GetTicks();
+                }
+            }
+        }
+
+        //burst window over (even if events keep coming): wake the event loop once
+        if(pending && SDL_GetTicks() - first_change >= WATCH_COALESCE_MS)
+        {
+            pending = false;
+            std::lock_guard<std::mutex> guard(watch->lock);
+            if(!watch->notified && (!watch->changed.empty() || watch->overflowed))
+            {
+                SDL_Event event;
+                SDL_memset(&event, 0, sizeof(event));
+                event.type = watch->event_type;
+                SDL_PushEvent(&event);
+                watch->notified = true;
+            }
+        }
+    }
+}